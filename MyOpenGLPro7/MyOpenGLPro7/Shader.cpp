@@ -7,122 +7,366 @@
 //
 #include <glad/glad.h> // include glad to get all the required OpenGL headers
 #include "headers/Shader.h"
+#include "headers/ShaderPreprocessor.h"
+#include "headers/GLStateCache.h"
 #include <string>
-#include <fstream>
-#include <sstream>
 #include <iostream>
-Shader::Shader(const char* vertexPath, const char* fragmentPath)
-{
-    // 1. retrieve the vertex/fragment source code from filePath
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
-    // ensure ifstream objects can throw exceptions:
-    vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-    try
-    {
-        // open files
-        
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        
-        std::stringstream vShaderStream, fShaderStream;
-        // read file's buffer contents into streams
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        // close file handlers
-        vShaderFile.close();
-        fShaderFile.close();
-        // convert stream into string
-        vertexCode   = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
-    }
-    catch(std::ifstream::failure e)
+#include <chrono>
+Shader::Shader() : ID(0)
+{
+}
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const ProgramCache* cache) : ID(0)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    // 1. map the vertex/fragment source code from filePath, resolving #include
+    ShaderPreprocessor preprocessor;
+    ShaderSource vertexSource = preprocessor.process(vertexPath);
+    ShaderSource fragmentSource = preprocessor.process(fragmentPath);
+    if (!checkSources(vertexSource, fragmentSource))
     {
-        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ"<< std::endl;
-        std::cout << e.what() << std::endl;
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ\n" << sourceError.describe() << std::endl;
+        return;
     }
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
     
+    // 2. reuse a cached program binary if the driver still accepts it
+    uint64_t cacheKey = 0;
+    bool cacheHit = loadCached(vertexSource, fragmentSource, cache, cacheKey);
+    // 3. otherwise compile and link
+    if (!cacheHit)
+        finish(submit(vertexSource, fragmentSource, cache), cache, cacheKey);
     
-    // 2. compile shaders
-    unsigned int vertex, fragment;
-    int success;
-    char infoLog[512];
+    reportBuild(cacheHit, std::string(vertexPath) + " + " + fragmentPath, start);
+}
+
+bool Shader::checkSources(const ShaderSource &vertexSource, const ShaderSource &fragmentSource)
+{
+    if (!vertexSource.ok())
+        sourceError = vertexSource.status();
+    else if (!fragmentSource.ok())
+        sourceError = fragmentSource.status();
+    return sourceError.status == SOURCE_OK;
+}
+
+bool Shader::loadCached(const ShaderSource &vertexSource, const ShaderSource &fragmentSource, const ProgramCache* cache, uint64_t &cacheKey)
+{
+    ID = 0;
+    cacheKey = 0;
+    if (cache && cache->supported())
+    {
+        cacheKey = cache->key(vertexSource.data(), vertexSource.length(), fragmentSource.data(), fragmentSource.length());
+        ID = cache->load(cacheKey);
+    }
+    if (ID)
+        reflectUniforms();
+    return ID != 0;
+}
+
+Shader::Pending Shader::submit(const ShaderSource &vertexSource, const ShaderSource &fragmentSource, const ProgramCache* cache)
+{
+    // both stages and the link are queued back to back; nothing asks for a
+    // status here, so the driver is free to compile them concurrently
+    Pending pending;
     
     // vertex Shader
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    // print compile errors if any
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-    if(!success)
-    {
-        glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-    };
+    pending.vertex = glCreateShader(GL_VERTEX_SHADER);
+    vertexSource.upload(pending.vertex);
+    glCompileShader(pending.vertex);
     
     // similiar for Fragment Shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    // print compile errors if any
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-    if(!success)
-    {
-        glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-    };
+    pending.fragment = glCreateShader(GL_FRAGMENT_SHADER);
+    fragmentSource.upload(pending.fragment);
+    glCompileShader(pending.fragment);
     
     // shader Program
     ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
+    glAttachShader(ID, pending.vertex);
+    glAttachShader(ID, pending.fragment);
+    if (cache)
+        cache->prepare(ID);
     glLinkProgram(ID);
-    // print linking errors if any
+    return pending;
+}
+
+bool Shader::finish(Pending pending, const ProgramCache* cache, uint64_t cacheKey)
+{
+    int success;
+    char infoLog[512];
+    
+    // a failed compile always fails the link, so one query covers the good case
     glGetProgramiv(ID, GL_LINK_STATUS, &success);
     if(!success)
     {
+        // print compile errors if any
+        glGetShaderiv(pending.vertex, GL_COMPILE_STATUS, &success);
+        if(!success)
+        {
+            glGetShaderInfoLog(pending.vertex, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+        }
+        glGetShaderiv(pending.fragment, GL_COMPILE_STATUS, &success);
+        if(!success)
+        {
+            glGetShaderInfoLog(pending.fragment, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+        }
+        // print linking errors if any
         glGetProgramInfoLog(ID, 512, NULL, infoLog);
         std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        success = 0;
+    }
+    else
+    {
+        if (cache)
+            cache->store(cacheKey, ID);
+        reflectUniforms();
     }
     
     // delete the shaders as they're linked into our program now and no longer necessery
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
-    
+    glDeleteShader(pending.vertex);
+    glDeleteShader(pending.fragment);
+    return success != 0;
 }
+
+void Shader::reportBuild(bool cacheHit, const std::string &name, std::chrono::steady_clock::time_point start)
+{
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "SHADER::PROGRAM::" << (cacheHit ? "CACHE_HIT " : "COMPILED ") << name << " in " << ms << " ms" << std::endl;
+}
+
 // activate the pipeline
 void Shader::use()
 {
-    glUseProgram(ID);
+    glState().useProgram(ID);
+}
+
+void Shader::reflectUniforms()
+{
+    uniformTable.clear();
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::string name(maxLength > 0 ? maxLength : 1, '\0');
+    for (GLint i = 0; i < count; i++)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, (GLuint)i, maxLength, &length, &size, &type, &name[0]);
+        std::string uniformName(name.c_str(), length);
+        GLint loc = glGetUniformLocation(ID, uniformName.c_str());
+        // members of uniform blocks have no location
+        if (loc < 0)
+            continue;
+        uniformTable.insert(uniformName, loc, type, size);
+        // arrays are reported as "name[0]" but are commonly addressed as "name"
+        if (length > 3 && uniformName.compare(length - 3, 3, "[0]") == 0)
+            uniformTable.insert(uniformName.substr(0, length - 3), loc, type, size);
+    }
+}
+
+GLint Shader::location(const std::string &name) const
+{
+    const UniformInfo *info = uniformTable.find(name);
+    return info ? info->location : -1;
+}
+
+GLint Shader::resolveSlot(const UniformSlot &slot) const
+{
+    const UniformInfo *info = uniformTable.find(slot.name);
+    if (info == NULL)
+        return -1;
+    if (!slot.matches(info->type))
+    {
+        std::cout << "ERROR::SHADER::UNIFORM::TYPE_MISMATCH " << slot.name << std::endl;
+        return -1;
+    }
+    return info->location;
+}
+
+// copy the current value of one uniform between two programs; fresh must be in use
+static void copyUniform(GLuint from, GLint fromLocation, GLint toLocation, GLenum type)
+{
+    GLfloat f[16];
+    GLint i[4];
+    GLuint u[4];
+    switch (type)
+    {
+        case GL_FLOAT: glGetUniformfv(from, fromLocation, f); glUniform1fv(toLocation, 1, f); break;
+        case GL_FLOAT_VEC2: glGetUniformfv(from, fromLocation, f); glUniform2fv(toLocation, 1, f); break;
+        case GL_FLOAT_VEC3: glGetUniformfv(from, fromLocation, f); glUniform3fv(toLocation, 1, f); break;
+        case GL_FLOAT_VEC4: glGetUniformfv(from, fromLocation, f); glUniform4fv(toLocation, 1, f); break;
+        case GL_FLOAT_MAT2: glGetUniformfv(from, fromLocation, f); glUniformMatrix2fv(toLocation, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT3: glGetUniformfv(from, fromLocation, f); glUniformMatrix3fv(toLocation, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT4: glGetUniformfv(from, fromLocation, f); glUniformMatrix4fv(toLocation, 1, GL_FALSE, f); break;
+        // bool vectors are read and set through the int entry points
+        case GL_INT_VEC2: case GL_BOOL_VEC2: glGetUniformiv(from, fromLocation, i); glUniform2iv(toLocation, 1, i); break;
+        case GL_INT_VEC3: case GL_BOOL_VEC3: glGetUniformiv(from, fromLocation, i); glUniform3iv(toLocation, 1, i); break;
+        case GL_INT_VEC4: case GL_BOOL_VEC4: glGetUniformiv(from, fromLocation, i); glUniform4iv(toLocation, 1, i); break;
+        case GL_UNSIGNED_INT: glGetUniformuiv(from, fromLocation, u); glUniform1uiv(toLocation, 1, u); break;
+        case GL_UNSIGNED_INT_VEC2: glGetUniformuiv(from, fromLocation, u); glUniform2uiv(toLocation, 1, u); break;
+        case GL_UNSIGNED_INT_VEC3: glGetUniformuiv(from, fromLocation, u); glUniform3uiv(toLocation, 1, u); break;
+        case GL_UNSIGNED_INT_VEC4: glGetUniformuiv(from, fromLocation, u); glUniform4uiv(toLocation, 1, u); break;
+        default:
+            // ints, bools and samplers (texture units)
+            glGetUniformiv(from, fromLocation, i);
+            glUniform1iv(toLocation, 1, i);
+            break;
+    }
+}
+
+void Shader::swapProgram(Shader &fresh)
+{
+    GLint current = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+    
+    // values set once at setup (texture units for example) must survive the swap
+    glState().useProgram(fresh.ID);
+    const std::vector<UniformInfo> &freshUniforms = fresh.uniformTable.all();
+    for (size_t n = 0; n < freshUniforms.size(); n++)
+    {
+        const UniformInfo &to = freshUniforms[n];
+        const UniformInfo *from = uniformTable.find(to.name);
+        if (!from || from->type != to.type)
+            continue;
+        // an array is listed twice, as "name[0]" and as "name"; copy it once
+        if (fresh.uniformTable.find(to.name + "[0]"))
+            continue;
+        GLint count = from->size < to.size ? from->size : to.size;
+        if (count == 1)
+        {
+            copyUniform(ID, from->location, to.location, to.type);
+            continue;
+        }
+        // array elements need not have contiguous locations, so each one is looked up by name;
+        // elements past the end of the shorter array are left alone
+        std::string base = to.name.substr(0, to.name.size() - 3);
+        for (GLint e = 0; e < count; e++)
+        {
+            std::string element = base + "[" + std::to_string(e) + "]";
+            GLint fromLocation = e == 0 ? from->location : glGetUniformLocation(ID, element.c_str());
+            GLint toLocation = e == 0 ? to.location : glGetUniformLocation(fresh.ID, element.c_str());
+            if (fromLocation >= 0 && toLocation >= 0)
+                copyUniform(ID, fromLocation, toLocation, to.type);
+        }
+    }
+    
+    GLuint old = ID;
+    ID = fresh.ID;
+    uniformTable = fresh.uniformTable;
+    fresh.ID = 0;
+    for (size_t i = 0; i < blockBindings.size(); i++)
+    {
+        GLuint index = glGetUniformBlockIndex(ID, blockBindings[i].first.c_str());
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, index, blockBindings[i].second);
+    }
+    for (size_t i = 0; i < slots.size(); i++)
+        slotLocations[i] = resolveSlot(slots[i]);
+    
+    glState().useProgram((GLuint)current == old ? ID : (GLuint)current);
+    glState().deleteProgram(old);
+}
+
+bool Shader::typeMatches(GLenum glType, const Uniform<bool>*)
+{
+    return glType == GL_BOOL;
+}
+
+bool Shader::typeMatches(GLenum glType, const Uniform<int>*)
+{
+    switch (glType)
+    {
+        case GL_INT: case GL_BOOL:
+        case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_BUFFER:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool Shader::typeMatches(GLenum glType, const Uniform<float>*)
+{
+    return glType == GL_FLOAT;
+}
+
+bool Shader::typeMatches(GLenum glType, const Uniform<glm::vec2>*)
+{
+    return glType == GL_FLOAT_VEC2;
+}
+
+bool Shader::typeMatches(GLenum glType, const Uniform<glm::mat4>*)
+{
+    return glType == GL_FLOAT_MAT4;
 }
 
 // set uniform variable name with value
+// names are looked up in the reflected table, not queried from the driver
 void Shader::setBool(const std::string &name, bool value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    glUniform1i(location(name), (int)value);
 }
 
 void Shader::setInt(const std::string &name, int value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1i(location(name), value);
 }
 
 void Shader::setFloat(const std::string &name, float value) const
 {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1f(location(name), value);
 }
 
 void Shader::setVec2(const std::string &name, float value1, float value2) const
 {
-    glUniform2f(glGetUniformLocation(ID, name.c_str()), value1, value2);
+    glUniform2f(location(name), value1, value2);
 }
 
 void Shader::setGlmValueMat4(const std::string &name, float value[]) const{
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, value);
+    glUniformMatrix4fv(location(name), 1, GL_FALSE, value);
 }
 
+void Shader::set(Uniform<bool> uniform, bool value) const
+{
+    glUniform1i(location(uniform.slot), (int)value);
+}
+
+void Shader::set(Uniform<int> uniform, int value) const
+{
+    glUniform1i(location(uniform.slot), value);
+}
+
+void Shader::set(Uniform<float> uniform, float value) const
+{
+    glUniform1f(location(uniform.slot), value);
+}
+
+void Shader::set(Uniform<glm::vec2> uniform, const glm::vec2 &value) const
+{
+    glUniform2f(location(uniform.slot), value.x, value.y);
+}
+
+void Shader::set(Uniform<glm::mat4> uniform, const glm::mat4 &value) const
+{
+    glUniformMatrix4fv(location(uniform.slot), 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void Shader::bindUniformBlock(const std::string &blockName, GLuint binding)
+{
+    bool known = false;
+    for (size_t i = 0; i < blockBindings.size(); i++)
+    {
+        if (blockBindings[i].first == blockName)
+        {
+            blockBindings[i].second = binding;
+            known = true;
+        }
+    }
+    if (!known)
+        blockBindings.push_back(std::make_pair(blockName, binding));
+    
+    GLuint index = glGetUniformBlockIndex(ID, blockName.c_str());
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(ID, index, binding);
+}
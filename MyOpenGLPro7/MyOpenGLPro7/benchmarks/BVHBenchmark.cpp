@@ -0,0 +1,166 @@
+//
+//  BVHBenchmark.cpp
+//  MyOpenGLPro7
+//
+//  SceneBVH at 10k, 100k and 1M unit boxes spread at constant density:
+//  build, refit after every box moved, frustum queries, rays and nearest
+//  object, each query next to the brute-force loop over all boxes it saves.
+//  The brute-force answers double as the check; any mismatch fails the run.
+//    c++ -std=gnu++14 -O2 -I<glad>/include benchmarks/BVHBenchmark.cpp -o BVHBenchmark
+//
+
+#include "../headers/SceneBVH.h"
+#include "../glm/glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+static const int RAYS = 1000;
+static const int POINTS = 1000;
+// brute force is slow at 1M, so it checks only the first few queries
+static const int CHECKED = 20;
+
+static float randomBetween(float low, float high)
+{
+    return low + (high - low) * (float)rand() / (float)RAND_MAX;
+}
+
+static double milliseconds(const std::function<void()> &work)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    work();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// entry distance of the ray into the box as SceneBVH measures it, FLT_MAX on a miss
+static float rayBox(const glm::vec3 &origin, const glm::vec3 &inverseDirection, const glm::vec3 &minimum, const glm::vec3 &maximum)
+{
+    glm::vec3 t0 = (minimum - origin) * inverseDirection;
+    glm::vec3 t1 = (maximum - origin) * inverseDirection;
+    glm::vec3 lower = glm::min(t0, t1), upper = glm::max(t0, t1);
+    float enter = std::max(std::max(lower.x, lower.y), std::max(lower.z, 0.0f));
+    float exit = std::min(std::min(upper.x, upper.y), upper.z);
+    return enter <= exit ? enter : FLT_MAX;
+}
+
+static float boxDistance(const glm::vec3 &point, const glm::vec3 &minimum, const glm::vec3 &maximum)
+{
+    glm::vec3 outside = glm::max(glm::max(minimum - point, point - maximum), glm::vec3(0.0f));
+    return glm::length(outside);
+}
+
+static bool run(size_t count)
+{
+    float side = 4.0f * std::cbrt((float)count);
+    std::vector<glm::vec3> centres(count);
+    SceneBVH bvh;
+    for (size_t i = 0; i < count; i++)
+    {
+        centres[i] = glm::vec3(randomBetween(-side, side), randomBetween(-side, side), randomBetween(-side, side)) * 0.5f;
+        bvh.add(centres[i] - 0.5f, centres[i] + 0.5f);
+    }
+    double buildMs = milliseconds([&]() { bvh.build(); });
+
+    // everything drifts a little, as the spinning cubes' boxes do
+    for (size_t i = 0; i < count; i++)
+    {
+        centres[i] += glm::vec3(randomBetween(-0.2f, 0.2f), randomBetween(-0.2f, 0.2f), randomBetween(-0.2f, 0.2f));
+        bvh.setBounds((uint32_t)i, centres[i] - 0.5f, centres[i] + 0.5f);
+    }
+    double refitMs = milliseconds([&]() { bvh.refit(); });
+    printf("\n%zu boxes in a %.0f unit cube: %zu nodes, build %.2f ms, refit %.2f ms\n", count, side, bvh.nodeCount(), buildMs, refitMs);
+    printf("%-8s %8s %12s %12s %10s\n", "query", "count", "BVH ms", "brute ms", "speed-up");
+    bool ok = true;
+
+    // Pro7's camera at the centre, looking down -z
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    Frustum frustum = Frustum::fromMatrix(projection * view);
+    std::vector<uint32_t> visible, expected;
+    double frustumMs = milliseconds([&]() { bvh.queryFrustum(frustum, visible); });
+    double bruteFrustumMs = milliseconds([&]() {
+        for (size_t i = 0; i < count; i++)
+            if (frustum.intersectsBox(centres[i] - 0.5f, centres[i] + 0.5f))
+                expected.push_back((uint32_t)i);
+    });
+    std::sort(visible.begin(), visible.end());
+    printf("%-8s %8zu %12.3f %12.3f %9.1fx\n", "frustum", visible.size(), frustumMs, bruteFrustumMs, bruteFrustumMs / frustumMs);
+    if (visible != expected)
+    {
+        printf("frustum query found %zu boxes, brute force %zu\n", visible.size(), expected.size());
+        ok = false;
+    }
+
+    // rays from near the centre in random directions, 100 units long
+    std::vector<glm::vec3> origins(RAYS), directions(RAYS);
+    for (int r = 0; r < RAYS; r++)
+    {
+        origins[r] = glm::vec3(randomBetween(-5.0f, 5.0f), randomBetween(-5.0f, 5.0f), randomBetween(-5.0f, 5.0f));
+        directions[r] = glm::normalize(glm::vec3(randomBetween(-1.0f, 1.0f), randomBetween(-1.0f, 1.0f), randomBetween(-1.0f, 1.0f)));
+    }
+    std::vector<SceneBVH::RayHit> hits(RAYS);
+    double rayMs = milliseconds([&]() {
+        for (int r = 0; r < RAYS; r++)
+            bvh.raycast(origins[r], directions[r], 100.0f, hits[r]);
+    });
+    int rayMismatches = 0;
+    double bruteRayMs = milliseconds([&]() {
+        for (int r = 0; r < CHECKED; r++)
+        {
+            glm::vec3 inverseDirection = 1.0f / directions[r];
+            float closest = 100.0f;
+            for (size_t i = 0; i < count; i++)
+                closest = std::min(closest, rayBox(origins[r], inverseDirection, centres[i] - 0.5f, centres[i] + 0.5f));
+            if (std::fabs(closest - hits[r].distance) > 1e-4f)
+                rayMismatches++;
+        }
+    }) * RAYS / CHECKED;
+    printf("%-8s %8d %12.3f %12.3f %9.1fx\n", "rays", RAYS, rayMs, bruteRayMs, bruteRayMs / rayMs);
+    if (rayMismatches)
+    {
+        printf("%d of %d rays disagree with brute force\n", rayMismatches, CHECKED);
+        ok = false;
+    }
+
+    std::vector<glm::vec3> points(POINTS);
+    for (int p = 0; p < POINTS; p++)
+        points[p] = glm::vec3(randomBetween(-side, side), randomBetween(-side, side), randomBetween(-side, side)) * 0.5f;
+    std::vector<float> distances(POINTS);
+    double nearestMs = milliseconds([&]() {
+        for (int p = 0; p < POINTS; p++)
+            bvh.nearest(points[p], side * 2.0f, distances[p]);
+    });
+    int nearestMismatches = 0;
+    double bruteNearestMs = milliseconds([&]() {
+        for (int p = 0; p < CHECKED; p++)
+        {
+            float closest = FLT_MAX;
+            for (size_t i = 0; i < count; i++)
+                closest = std::min(closest, boxDistance(points[p], centres[i] - 0.5f, centres[i] + 0.5f));
+            if (std::fabs(closest - distances[p]) > 1e-4f)
+                nearestMismatches++;
+        }
+    }) * POINTS / CHECKED;
+    printf("%-8s %8d %12.3f %12.3f %9.1fx\n", "nearest", POINTS, nearestMs, bruteNearestMs, bruteNearestMs / nearestMs);
+    if (nearestMismatches)
+    {
+        printf("%d of %d nearest queries disagree with brute force\n", nearestMismatches, CHECKED);
+        ok = false;
+    }
+    return ok;
+}
+
+int main()
+{
+    srand(9);
+    const size_t counts[] = { 10000, 100000, 1000000 };
+    bool ok = true;
+    for (size_t count : counts)
+        ok = run(count) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,193 @@
+//
+//  CameraBenchmark.cpp
+//  MyOpenGLPro7
+//
+//  1000 cameras, each asked for its view-projection four times per frame as
+//  culling, picking and the draw do, once with the cameras standing still and
+//  once with every camera turning and moving each frame. The old camera (Euler
+//  angles, glm::lookAt and glm::perspective on every call) runs against Camera
+//  with its quaternion and cached matrices, fed the same input. Afterwards
+//  every Camera's GetViewMatrix must match glm::lookAt and the old camera's
+//  view; any mismatch fails the run.
+//    c++ -std=gnu++14 -O2 -I<glad>/include benchmarks/CameraBenchmark.cpp -o CameraBenchmark
+//
+
+#include "../headers/camera.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+static const int CAMERAS = 1000;
+static const int FRAMES = 200;
+static const int QUERIES = 4;
+static const float TOLERANCE = 1e-4f;
+
+// camera.h before the quaternion: Euler angles, nothing cached
+struct EulerCamera
+{
+    glm::vec3 Position;
+    glm::vec3 Front;
+    glm::vec3 Up;
+    glm::vec3 Right;
+    glm::vec3 WorldUp;
+    float Yaw;
+    float Pitch;
+    float Zoom;
+
+    EulerCamera(glm::vec3 position, float yaw, float pitch)
+        : Position(position), WorldUp(0.0f, 1.0f, 0.0f), Yaw(yaw), Pitch(pitch), Zoom(ZOOM)
+    {
+        updateCameraVectors();
+    }
+
+    glm::mat4 GetViewMatrix() const
+    {
+        return glm::lookAt(Position, Position + Front, Up);
+    }
+
+    glm::mat4 GetViewProjectionMatrix(float aspect) const
+    {
+        return glm::perspective(glm::radians(Zoom), aspect, 0.1f, 100.0f) * GetViewMatrix();
+    }
+
+    void ProcessKeyboard(float velocity)
+    {
+        Position += Front * velocity;
+        Position += Right * velocity;
+    }
+
+    void ProcessMouseMovement(float xoffset, float yoffset)
+    {
+        Yaw += xoffset * SENSITIVITY;
+        Pitch += yoffset * SENSITIVITY;
+        if (Pitch > 89.0f)
+            Pitch = 89.0f;
+        if (Pitch < -89.0f)
+            Pitch = -89.0f;
+        updateCameraVectors();
+    }
+
+    void updateCameraVectors()
+    {
+        glm::vec3 front;
+        front.x = cos(glm::radians(Yaw)) * cos(glm::radians(Pitch));
+        front.y = sin(glm::radians(Pitch));
+        front.z = sin(glm::radians(Yaw)) * cos(glm::radians(Pitch));
+        Front = glm::normalize(front);
+        Right = glm::normalize(glm::cross(Front, WorldUp));
+        Up    = glm::normalize(glm::cross(Right, Front));
+    }
+};
+
+static float randomBetween(float low, float high)
+{
+    return low + (high - low) * (float)rand() / (float)RAND_MAX;
+}
+
+static double milliseconds(const std::function<void()> &work)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    work();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// the translation column is a dot product with the position, so its rounding grows with the distance from the origin
+static bool closeEnough(const glm::mat4 &a, const glm::mat4 &b, const glm::vec3 &position)
+{
+    float distance = std::fmax(1.0f, glm::length(position));
+    for (int c = 0; c < 4; c++)
+        for (int r = 0; r < 4; r++)
+            if (std::fabs(a[c][r] - b[c][r]) > TOLERANCE * (c == 3 ? distance : 1.0f))
+                return false;
+    return true;
+}
+
+// the frame's mouse and keyboard input for camera i, the same for both kinds
+static glm::vec3 input(int frame, int i)
+{
+    float phase = (float)(frame + i);
+    return glm::vec3(std::sin(phase * 0.37f) * 4.0f, std::cos(phase * 0.23f) * 3.0f, 0.01f);
+}
+
+int main()
+{
+    const float aspect = 800.0f / 600.0f;
+    srand(21);
+    std::vector<EulerCamera> euler;
+    std::vector<Camera> cameras;
+    for (int i = 0; i < CAMERAS; i++)
+    {
+        glm::vec3 position(randomBetween(-50.0f, 50.0f), randomBetween(-50.0f, 50.0f), randomBetween(-50.0f, 50.0f));
+        float yaw = randomBetween(-180.0f, 180.0f), pitch = randomBetween(-60.0f, 60.0f);
+        euler.push_back(EulerCamera(position, yaw, pitch));
+        cameras.push_back(Camera(position, glm::vec3(0.0f, 1.0f, 0.0f), yaw, pitch));
+        cameras.back().SetProjection(aspect, 0.1f, 100.0f);
+    }
+
+    // summed so the compiler cannot drop the queries
+    float sink = 0.0f;
+    printf("%d cameras, %d view-projection queries each per frame, ms per frame\n", CAMERAS, QUERIES);
+    printf("%-10s %14s %14s %10s\n", "cameras", "Euler/lookAt", "quaternion", "speed-up");
+
+    double eulerStill = milliseconds([&]() {
+        for (int frame = 0; frame < FRAMES; frame++)
+            for (EulerCamera &camera : euler)
+                for (int q = 0; q < QUERIES; q++)
+                    sink += camera.GetViewProjectionMatrix(aspect)[3][2];
+    }) / FRAMES;
+    double cachedStill = milliseconds([&]() {
+        for (int frame = 0; frame < FRAMES; frame++)
+            for (Camera &camera : cameras)
+                for (int q = 0; q < QUERIES; q++)
+                    sink += camera.GetViewProjectionMatrix()[3][2];
+    }) / FRAMES;
+    printf("%-10s %14.3f %14.3f %9.1fx\n", "unchanged", eulerStill, cachedStill, eulerStill / cachedStill);
+
+    double eulerMoving = milliseconds([&]() {
+        for (int frame = 0; frame < FRAMES; frame++)
+            for (int i = 0; i < CAMERAS; i++)
+            {
+                glm::vec3 move = input(frame, i);
+                euler[i].ProcessMouseMovement(move.x, move.y);
+                euler[i].ProcessKeyboard(move.z);
+                for (int q = 0; q < QUERIES; q++)
+                    sink += euler[i].GetViewProjectionMatrix(aspect)[3][2];
+            }
+    }) / FRAMES;
+    double cachedMoving = milliseconds([&]() {
+        for (int frame = 0; frame < FRAMES; frame++)
+            for (int i = 0; i < CAMERAS; i++)
+            {
+                glm::vec3 move = input(frame, i);
+                cameras[i].ProcessMouseMovement(move.x, move.y);
+                cameras[i].ProcessKeyboard(FORWARD, move.z / SPEED);
+                cameras[i].ProcessKeyboard(RIGHT, move.z / SPEED);
+                for (int q = 0; q < QUERIES; q++)
+                    sink += cameras[i].GetViewProjectionMatrix()[3][2];
+            }
+    }) / FRAMES;
+    printf("%-10s %14.3f %14.3f %9.1fx\n", "moving", eulerMoving, cachedMoving, eulerMoving / cachedMoving);
+
+    // both kinds walked the same path, so their views must agree with each other and with lookAt
+    int lookAtMismatches = 0, eulerMismatches = 0;
+    for (int i = 0; i < CAMERAS; i++)
+    {
+        const Camera &camera = cameras[i];
+        if (!closeEnough(camera.GetViewMatrix(), glm::lookAt(camera.Position, camera.Position + camera.Front, camera.Up), camera.Position))
+            lookAtMismatches++;
+        if (!closeEnough(camera.GetViewMatrix(), euler[i].GetViewMatrix(), camera.Position))
+            eulerMismatches++;
+    }
+    printf("(sink %g)\n", sink);
+    if (lookAtMismatches || eulerMismatches)
+    {
+        printf("%d views differ from glm::lookAt, %d from the Euler camera\n", lookAtMismatches, eulerMismatches);
+        return 1;
+    }
+    printf("every view matches glm::lookAt and the Euler camera within %g (times the distance for the translation)\n", TOLERANCE);
+    return 0;
+}
@@ -0,0 +1,124 @@
+//
+//  InstanceSweepBenchmark.cpp
+//  MyOpenGLPro7
+//
+//  The cube scene at 10 to 100k cubes, drawn the way Pro7 used to (a model
+//  uniform and a glDrawArrays per cube) and through RenderQueue, with and
+//  without multi-draw indirect, against GLRecorder instead of a driver.
+//  Prints GL calls, the bytes GLRecorder saw written to buffers (mapped
+//  ranges plus glBufferSubData: instances, and commands for indirect) and
+//  CPU time per frame; the stubs return at once, so the per-cube path's time
+//  is a lower bound.
+//    c++ -std=gnu++14 -O2 -I<glad>/include benchmarks/InstanceSweepBenchmark.cpp <glad>/src/glad.c -o InstanceSweepBenchmark
+//
+
+#include "../tests/GLRecorder.h"
+#include "../headers/GLStateCache.h"
+#include "../headers/RenderQueue.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+static const GLuint PROGRAM = 1;
+static const GLuint VAO = 2;
+static const GLint MODEL_LOCATION = 0;
+
+struct Result
+{
+    double callsPerFrame;
+    double instancesPerFrame;
+    double kibPerFrame;
+    double microsecondsPerFrame;
+};
+
+static std::vector<glm::mat4> cubeModels(int count)
+{
+    std::vector<glm::mat4> models(count, glm::mat4(1.0f));
+    for (int i = 0; i < count; i++)
+        models[i][3] = glm::vec4((float)(i % 100), (float)(i / 100 % 100), -(float)(i / 10000) - 1.0f, 1.0f);
+    return models;
+}
+
+static int framesFor(int count)
+{
+    int frames = 2000000 / count;
+    return frames < 20 ? 20 : frames > 2000 ? 2000 : frames;
+}
+
+template <typename DrawFrame>
+static Result run(int count, DrawFrame drawFrame)
+{
+    int frames = framesFor(count);
+    drawFrame();
+    glRecorder().reset();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+        drawFrame();
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    Result result;
+    result.callsPerFrame = (double)glRecorder().totalCalls() / frames;
+    result.instancesPerFrame = (double)glRecorder().instancesDrawn / frames;
+    result.kibPerFrame = (double)glRecorder().bytesUploaded / 1024.0 / frames;
+    result.microsecondsPerFrame = us / frames;
+    return result;
+}
+
+// the old loop: one uniform update and one draw per cube
+static Result perCube(const std::vector<glm::mat4> &models)
+{
+    return run((int)models.size(), [&]() {
+        glState().useProgram(PROGRAM);
+        glState().bindVertexArray(VAO);
+        for (size_t i = 0; i < models.size(); i++)
+        {
+            glUniformMatrix4fv(MODEL_LOCATION, 1, GL_FALSE, &models[i][0][0]);
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+        }
+    });
+}
+
+static Result queued(const std::vector<glm::mat4> &models, bool indirect)
+{
+    installGLRecorder(indirect);
+    glState().invalidate();
+    RenderQueue queue;
+    GLuint texture = 3;
+    uint32_t textures = queue.addTextureSet(&texture, 1);
+    uint32_t mesh = queue.addMesh(VAO, 36);
+    Result result = run((int)models.size(), [&]() {
+        for (size_t i = 0; i < models.size(); i++)
+            queue.submit(RenderQueue::PASS_OPAQUE, PROGRAM, textures, mesh, -models[i][3].z, models[i]);
+        queue.flush();
+        queue.endFrame();
+    });
+    queue.release();
+    return result;
+}
+
+int main()
+{
+    installGLRecorder();
+    printf("%8s | %-26s | %-26s | %-26s\n", "cubes", "per cube", "RenderQueue", "RenderQueue + indirect");
+    printf("%8s | %8s %8s %8s | %8s %8s %8s | %8s %8s %8s\n", "", "calls", "drawn", "us", "calls", "KiB", "us", "calls", "KiB", "us");
+    const int counts[] = { 10, 100, 1000, 10000, 100000 };
+    for (int count : counts)
+    {
+        std::vector<glm::mat4> models = cubeModels(count);
+        installGLRecorder();
+        glState().invalidate();
+        Result naive = perCube(models);
+        Result instanced = queued(models, false);
+        Result indirect = queued(models, true);
+        printf("%8d | %8.0f %8.0f %8.1f | %8.0f %8.1f %8.1f | %8.0f %8.1f %8.1f\n", count,
+               naive.callsPerFrame, naive.instancesPerFrame, naive.microsecondsPerFrame,
+               instanced.callsPerFrame, instanced.kibPerFrame, instanced.microsecondsPerFrame,
+               indirect.callsPerFrame, indirect.kibPerFrame, indirect.microsecondsPerFrame);
+        if (instanced.instancesPerFrame != count || indirect.instancesPerFrame != count)
+        {
+            printf("RenderQueue drew %.0f / %.0f instances of %d\n", instanced.instancesPerFrame, indirect.instancesPerFrame, count);
+            return 1;
+        }
+    }
+    return 0;
+}
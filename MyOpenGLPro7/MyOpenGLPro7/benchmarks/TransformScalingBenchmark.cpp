@@ -0,0 +1,88 @@
+//
+//  TransformScalingBenchmark.cpp
+//  MyOpenGLPro7
+//
+//  CubeTransforms::update through JobSystem on 1 to all cores, for 10k to 1M
+//  cubes, next to the plain single-threaded loop it replaced. Prints ms per
+//  update and the speed-up over one thread. Needs no GL; an optional
+//  argument caps the thread count (e.g. to try more threads than cores).
+//    c++ -std=gnu++14 -O2 -pthread -I<glad>/include benchmarks/TransformScalingBenchmark.cpp -o TransformScalingBenchmark
+//
+
+#include "../headers/CubeTransforms.h"
+#include "../headers/JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+#include <vector>
+
+static double millisecondsPer(int repeats, const std::function<void(int)> &work)
+{
+    work(0);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int r = 1; r <= repeats; r++)
+        work(r);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeats;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int cores = std::thread::hardware_concurrency();
+    unsigned int maxThreads = argc > 1 ? (unsigned int)atoi(argv[1]) : cores;
+    if (maxThreads < 1)
+        maxThreads = 1;
+    printf("%u hardware threads, testing 1 to %u\n", cores, maxThreads);
+
+    const size_t counts[] = { 10000, 100000, 1000000 };
+    for (size_t count : counts)
+    {
+        CubeTransforms cubes;
+        for (size_t i = 0; i < count; i++)
+            cubes.add(glm::vec3((float)(i % 100), (float)(i / 100 % 100), -(float)(i / 10000)), 0.5f + (float)(i % 7) * 0.1f);
+        int repeats = (int)(20000000 / count);
+
+        // the loop CubeTransforms replaced: one glm::translate * glm::rotate per cube
+        std::vector<glm::mat4> serial(count);
+        double loop = millisecondsPer(repeats, [&](int r) {
+            float time = r * 0.016f;
+            for (size_t i = 0; i < count; i++)
+            {
+                glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(cubes.positionsX()[i], cubes.positionsY()[i], cubes.positionsZ()[i]));
+                serial[i] = glm::rotate(model, time * (0.5f + (float)(i % 7) * 0.1f), glm::vec3(1.0f, 0.3f, 0.5f));
+            }
+        });
+        printf("\n%zu cubes: serial glm loop %.3f ms\n", count, loop);
+        printf("%8s %10s %10s %12s\n", "threads", "ms", "speed-up", "Mcubes/s");
+
+        double single = 0.0;
+        for (unsigned int threads = 1; threads <= maxThreads; threads++)
+        {
+            // the calling thread works too, so threads - 1 workers
+            JobSystem jobs(threads - 1);
+            double ms = millisecondsPer(repeats, [&](int r) { cubes.update(jobs, r * 0.016f); });
+            if (threads == 1)
+                single = ms;
+            printf("%8u %10.3f %10.2f %12.1f\n", threads, ms, single / ms, count / ms / 1000.0);
+        }
+
+        // both paths must agree
+        JobSystem alone(0);
+        cubes.update(alone, 0.016f * repeats);
+        float worst = 0.0f;
+        for (size_t i = 0; i < count; i += 997)
+            for (int c = 0; c < 4; c++)
+                for (int k = 0; k < 4; k++)
+                    worst = std::max(worst, std::fabs(cubes.data()[i][c][k] - serial[i][c][k]));
+        if (worst > 1e-3f)
+        {
+            printf("CubeTransforms differs from glm by %g\n", worst);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+//
+//  UniformLookupBenchmark.cpp
+//  MyOpenGLPro7
+//
+//  GL calls and CPU time per frame for three ways of setting the same
+//  uniforms, against GLRecorder instead of a driver:
+//    lookup  - glGetUniformLocation before every glUniform*, as Shader did
+//              before it reflected its uniforms
+//    table   - Shader's name setters, one UniformTable probe per set
+//    handles - Shader::set(Uniform<T>), an index into the slot locations
+//  The stubs cost the same for every call, so the time only shows the CPU
+//  side of the lookup; the call counts are what a real driver pays for.
+//  Run from the directory holding vshader.vs and fshader.fs:
+//    c++ -std=gnu++14 -O2 -I<glad>/include -I<glfw>/include benchmarks/UniformLookupBenchmark.cpp Shader.cpp <glad>/src/glad.c -o UniformLookupBenchmark
+//
+
+#include "../tests/GLRecorder.h"
+#include "../headers/Shader.h"
+
+#include <chrono>
+#include <cstdio>
+
+// objects drawn per frame, each with its own model matrix and tint
+static const int OBJECTS = 1000;
+static const int FRAMES = 200;
+
+static void perCallLookup(GLuint program, const glm::mat4 &model, const glm::vec2 &tint)
+{
+    glUniformMatrix4fv(glGetUniformLocation(program, "model"), 1, GL_FALSE, &model[0][0]);
+    glUniform2fv(glGetUniformLocation(program, "ourGB"), 1, &tint[0]);
+}
+
+static void tableLookup(const Shader &shader, glm::mat4 &model, const glm::vec2 &tint)
+{
+    shader.setGlmValueMat4("model", &model[0][0]);
+    shader.setVec2("ourGB", tint.x, tint.y);
+}
+
+struct Result
+{
+    double callsPerFrame;
+    double lookupsPerFrame;
+    double nsPerSet;
+};
+
+template <typename SetObject>
+static Result run(SetObject setObject)
+{
+    glRecorder().reset();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < FRAMES; frame++)
+        for (int i = 0; i < OBJECTS; i++)
+        {
+            glm::mat4 model(1.0f);
+            model[3] = glm::vec4((float)i, (float)frame, 0.0f, 1.0f);
+            setObject(model, glm::vec2((float)i / OBJECTS, (float)frame / FRAMES));
+        }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    Result result;
+    result.callsPerFrame = (double)glRecorder().totalCalls() / FRAMES;
+    result.lookupsPerFrame = (double)glRecorder().calls("glGetUniformLocation") / FRAMES;
+    result.nsPerSet = ns / ((double)FRAMES * OBJECTS * 2);
+    return result;
+}
+
+static void report(const char *name, const Result &result)
+{
+    printf("%-8s %10.0f %12.0f %12.1f\n", name, result.callsPerFrame, result.lookupsPerFrame, result.nsPerSet);
+}
+
+int main()
+{
+    installGLRecorder();
+    // the uniforms vshader.vs and fshader.fs declare, plus a few a lit scene would add
+    const GLRecorder::ActiveUniform uniforms[] = {
+        { "model", GL_FLOAT_MAT4, 1 },
+        { "texture1", GL_SAMPLER_2D, 1 },
+        { "texture2", GL_SAMPLER_2D, 1 },
+        { "ourGB", GL_FLOAT_VEC2, 1 },
+        { "lightColor", GL_FLOAT_VEC3, 1 },
+        { "lightPosition", GL_FLOAT_VEC3, 1 },
+        { "shininess", GL_FLOAT, 1 },
+        { "normalMatrix", GL_FLOAT_MAT3, 1 }
+    };
+    glRecorder().uniforms.assign(uniforms, uniforms + sizeof(uniforms) / sizeof(uniforms[0]));
+
+    Shader shader("vshader.vs", "fshader.fs");
+    if (!shader.ID)
+    {
+        printf("vshader.vs / fshader.fs not found, run from the MyOpenGLPro7 source directory\n");
+        return 1;
+    }
+    Uniform<glm::mat4> modelUniform = shader.getUniform<glm::mat4>("model");
+    Uniform<glm::vec2> tintUniform = shader.getUniform<glm::vec2>("ourGB");
+    GLuint program = shader.ID;
+
+    Result lookup = run([program](glm::mat4 &model, const glm::vec2 &tint) { perCallLookup(program, model, tint); });
+    Result table = run([&shader](glm::mat4 &model, const glm::vec2 &tint) { tableLookup(shader, model, tint); });
+    Result handles = run([&](glm::mat4 &model, const glm::vec2 &tint) {
+        shader.set(modelUniform, model);
+        shader.set(tintUniform, tint);
+    });
+
+    printf("%d objects x 2 uniforms per frame, %d frames\n", OBJECTS, FRAMES);
+    printf("%-8s %10s %12s %12s\n", "", "GL calls", "location", "ns per set");
+    report("lookup", lookup);
+    report("table", table);
+    report("handles", handles);
+    return 0;
+}
@@ -1,12 +1,31 @@
-
 #version 330 core
 out vec4 FragColor;
 
+// variant switches, injected by ShaderPreprocessor; defaults match the original shader
+#ifndef SAMPLER_COUNT
+#define SAMPLER_COUNT 2
+#endif
+#ifndef USE_TINT
+#define USE_TINT 1
+#endif
+
 in vec2 loc;
 uniform sampler2D texture1;
+#if SAMPLER_COUNT > 1
 uniform sampler2D texture2;
+#endif
+#if USE_TINT
 uniform vec2 ourGB;
+#endif
 void main()
 {
-    FragColor = mix(texture(texture1, loc), texture(texture2, loc), 0.2) * vec4(1.0, ourGB, 1.0);
+#if SAMPLER_COUNT > 1
+    vec4 color = mix(texture(texture1, loc), texture(texture2, loc), 0.2);
+#else
+    vec4 color = texture(texture1, loc);
+#endif
+#if USE_TINT
+    color *= vec4(1.0, ourGB, 1.0);
+#endif
+    FragColor = color;
 }
@@ -0,0 +1,247 @@
+//
+//  CameraArray.h
+//  MyOpenGLPro7
+//
+
+#ifndef CAMERA_ARRAY_H
+#define CAMERA_ARRAY_H
+
+#include "../glm/glm/glm.hpp"
+#include "../glm/glm/gtc/matrix_transform.hpp"
+#include "../glm/glm/gtc/quaternion.hpp"
+#include "camera.h"
+#include "Frustum.h"
+
+#include <cmath>
+#include <vector>
+
+// Many views at once (shadow cascades, cube map faces, split screen) kept as
+// structure-of-arrays: position, orientation, zoom, aspect and near/far each
+// in their own array. update() builds view, projection, view-projection and
+// the frustum of every camera in one pass; with SSE it works on four cameras
+// at a time, one per lane, so the quaternion to matrix conversion, the
+// product with the (mostly zero) projection and the plane extraction are all
+// plain vertical arithmetic. There is no NEON version of that yet, so on
+// ARM every camera takes the scalar path. Orientations follow Camera: the
+// camera looks down its own -z. Projections are always
+// Camera::DEPTH_STANDARD; shadow cascades and probes want a finite far plane
+// anyway.
+class CameraArray
+{
+public:
+    size_t add(const glm::vec3 &position, const glm::quat &orientation, float zoom, float aspect, float nearPlane, float farPlane)
+    {
+        x.push_back(position.x);
+        y.push_back(position.y);
+        z.push_back(position.z);
+        qx.push_back(orientation.x);
+        qy.push_back(orientation.y);
+        qz.push_back(orientation.z);
+        qw.push_back(orientation.w);
+        zooms.push_back(zoom);
+        aspects.push_back(aspect);
+        nears.push_back(nearPlane);
+        fars.push_back(farPlane);
+        return x.size() - 1;
+    }
+
+    size_t add(const Camera &camera)
+    {
+        return add(camera.Position, camera.Orientation, camera.Zoom, camera.Aspect, camera.Near, camera.Far);
+    }
+
+    void setPosition(size_t i, const glm::vec3 &position)
+    {
+        x[i] = position.x;
+        y[i] = position.y;
+        z[i] = position.z;
+    }
+
+    void setOrientation(size_t i, const glm::quat &orientation)
+    {
+        qx[i] = orientation.x;
+        qy[i] = orientation.y;
+        qz[i] = orientation.z;
+        qw[i] = orientation.w;
+    }
+
+    // zoom is the vertical field of view in degrees, as Camera::Zoom
+    void setProjection(size_t i, float zoom, float aspect, float nearPlane, float farPlane)
+    {
+        zooms[i] = zoom;
+        aspects[i] = aspect;
+        nears[i] = nearPlane;
+        fars[i] = farPlane;
+    }
+
+    void set(size_t i, const Camera &camera)
+    {
+        setPosition(i, camera.Position);
+        setOrientation(i, camera.Orientation);
+        setProjection(i, camera.Zoom, camera.Aspect, camera.Near, camera.Far);
+    }
+
+    void clear()
+    {
+        x.clear(); y.clear(); z.clear();
+        qx.clear(); qy.clear(); qz.clear(); qw.clear();
+        zooms.clear(); aspects.clear(); nears.clear(); fars.clear();
+    }
+
+    size_t size() const { return x.size(); }
+
+    // rebuilds the matrices and frustums of all cameras
+    void update()
+    {
+        size_t count = size();
+        views.resize(count);
+        projections.resize(count);
+        viewProjections.resize(count);
+        frustums.resize(count);
+        size_t i = 0;
+#ifdef FRUSTUM_SSE
+        for (; i + 4 <= count; i += 4)
+            computeFour(i);
+#endif
+        for (; i < count; i++)
+            computeOne(i);
+    }
+
+    // valid after update(), in the order the cameras were added
+    const glm::mat4& view(size_t i) const { return views[i]; }
+    const glm::mat4& projection(size_t i) const { return projections[i]; }
+    const glm::mat4& viewProjection(size_t i) const { return viewProjections[i]; }
+    const Frustum& frustum(size_t i) const { return frustums[i]; }
+
+private:
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> qx;
+    std::vector<float> qy;
+    std::vector<float> qz;
+    std::vector<float> qw;
+    std::vector<float> zooms;
+    std::vector<float> aspects;
+    std::vector<float> nears;
+    std::vector<float> fars;
+    std::vector<glm::mat4> views;
+    std::vector<glm::mat4> projections;
+    std::vector<glm::mat4> viewProjections;
+    std::vector<Frustum> frustums;
+
+    void computeOne(size_t i)
+    {
+        glm::quat orientation(qw[i], qx[i], qy[i], qz[i]);
+        glm::vec3 position(x[i], y[i], z[i]);
+        glm::mat3 rotation = glm::mat3_cast(glm::conjugate(orientation));
+        glm::mat4 view(rotation);
+        view[3] = glm::vec4(-(rotation * position), 1.0f);
+        views[i] = view;
+        projections[i] = glm::perspective(glm::radians(zooms[i]), aspects[i], nears[i], fars[i]);
+        viewProjections[i] = projections[i] * view;
+        frustums[i] = Frustum::fromMatrix(viewProjections[i]);
+    }
+
+#ifdef FRUSTUM_SSE
+    // a..d are rows 0..3 of one column, a camera per lane; writes that column of four consecutive matrices
+    static void storeColumns(__m128 a, __m128 b, __m128 c, __m128 d, glm::mat4 *matrices, int column)
+    {
+        _MM_TRANSPOSE4_PS(a, b, c, d);
+        _mm_storeu_ps(&matrices[0][column][0], a);
+        _mm_storeu_ps(&matrices[1][column][0], b);
+        _mm_storeu_ps(&matrices[2][column][0], c);
+        _mm_storeu_ps(&matrices[3][column][0], d);
+    }
+
+    // same as computeOne for cameras i..i+3, one per lane
+    void computeFour(size_t i)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 two = _mm_set1_ps(2.0f);
+
+        // the rotation's columns are the camera's right, up and back vectors
+        __m128 ox = _mm_loadu_ps(&qx[i]), oy = _mm_loadu_ps(&qy[i]), oz = _mm_loadu_ps(&qz[i]), ow = _mm_loadu_ps(&qw[i]);
+        __m128 xx = _mm_mul_ps(ox, ox), yy = _mm_mul_ps(oy, oy), zz = _mm_mul_ps(oz, oz);
+        __m128 xy = _mm_mul_ps(ox, oy), xz = _mm_mul_ps(ox, oz), yz = _mm_mul_ps(oy, oz);
+        __m128 wx = _mm_mul_ps(ow, ox), wy = _mm_mul_ps(ow, oy), wz = _mm_mul_ps(ow, oz);
+        __m128 rightX = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+        __m128 rightY = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+        __m128 rightZ = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+        __m128 upX = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+        __m128 upY = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+        __m128 upZ = _mm_mul_ps(two, _mm_add_ps(yz, wx));
+        __m128 backX = _mm_mul_ps(two, _mm_add_ps(xz, wy));
+        __m128 backY = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+        __m128 backZ = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+
+        // view rows: (right, -right.p), (up, -up.p), (back, -back.p), (0, 0, 0, 1)
+        __m128 px = _mm_loadu_ps(&x[i]), py = _mm_loadu_ps(&y[i]), pz = _mm_loadu_ps(&z[i]);
+        __m128 view[3][4] = {
+            { rightX, rightY, rightZ, negativeDot(rightX, rightY, rightZ, px, py, pz) },
+            { upX, upY, upZ, negativeDot(upX, upY, upZ, px, py, pz) },
+            { backX, backY, backZ, negativeDot(backX, backY, backZ, px, py, pz) }
+        };
+
+        // glm::perspective: only the diagonal, (2, 3) = -1 and (3, 2) are non-zero
+        float tangents[4];
+        for (int k = 0; k < 4; k++)
+            tangents[k] = std::tan(glm::radians(zooms[i + k]) * 0.5f);
+        __m128 nearPlane = _mm_loadu_ps(&nears[i]), farPlane = _mm_loadu_ps(&fars[i]);
+        __m128 range = _mm_sub_ps(farPlane, nearPlane);
+        __m128 scaleY = _mm_div_ps(one, _mm_loadu_ps(tangents));
+        __m128 scaleX = _mm_div_ps(scaleY, _mm_loadu_ps(&aspects[i]));
+        __m128 depthScale = _mm_div_ps(_mm_sub_ps(zero, _mm_add_ps(farPlane, nearPlane)), range);
+        __m128 depthOffset = _mm_div_ps(_mm_mul_ps(_mm_set1_ps(-2.0f), _mm_mul_ps(farPlane, nearPlane)), range);
+
+        // rows of projection * view
+        __m128 viewProjection[4][4];
+        for (int c = 0; c < 4; c++)
+        {
+            viewProjection[0][c] = _mm_mul_ps(scaleX, view[0][c]);
+            viewProjection[1][c] = _mm_mul_ps(scaleY, view[1][c]);
+            viewProjection[2][c] = _mm_mul_ps(depthScale, view[2][c]);
+            viewProjection[3][c] = _mm_sub_ps(zero, view[2][c]);
+        }
+        viewProjection[2][3] = _mm_add_ps(viewProjection[2][3], depthOffset);
+
+        for (int c = 0; c < 4; c++)
+        {
+            if (c < 3)
+                storeColumns(view[0][c], view[1][c], view[2][c], zero, &views[i], c);
+            else
+                storeColumns(view[0][c], view[1][c], view[2][c], one, &views[i], c);
+            storeColumns(viewProjection[0][c], viewProjection[1][c], viewProjection[2][c], viewProjection[3][c], &viewProjections[i], c);
+        }
+        storeColumns(scaleX, zero, zero, zero, &projections[i], 0);
+        storeColumns(zero, scaleY, zero, zero, &projections[i], 1);
+        storeColumns(zero, zero, depthScale, _mm_set1_ps(-1.0f), &projections[i], 2);
+        storeColumns(zero, zero, depthOffset, zero, &projections[i], 3);
+
+        // Gribb/Hartmann as in Frustum::fromMatrix, normalised per lane
+        for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+        {
+            const __m128 *row = viewProjection[p / 2];
+            __m128 plane[4];
+            for (int c = 0; c < 4; c++)
+                plane[c] = p % 2 ? _mm_sub_ps(viewProjection[3][c], row[c]) : _mm_add_ps(viewProjection[3][c], row[c]);
+            __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(plane[0], plane[0]), _mm_mul_ps(plane[1], plane[1])),
+                                                   _mm_mul_ps(plane[2], plane[2])));
+            for (int c = 0; c < 4; c++)
+                plane[c] = _mm_div_ps(plane[c], length);
+            _MM_TRANSPOSE4_PS(plane[0], plane[1], plane[2], plane[3]);
+            for (int k = 0; k < 4; k++)
+                _mm_storeu_ps(&frustums[i + k].planes[p][0], plane[k]);
+        }
+    }
+
+    static __m128 negativeDot(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+    {
+        __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+        return _mm_sub_ps(_mm_setzero_ps(), dot);
+    }
+#endif
+};
+
+#endif
@@ -0,0 +1,207 @@
+//
+//  CameraPath.h
+//  MyOpenGLPro7
+//
+
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include "../glm/glm/glm.hpp"
+#include "../glm/glm/gtx/spline.hpp"
+#include "camera.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// A camera fly-through as timestamped keys (position, yaw, pitch, zoom),
+// thinned out to one key per keyInterval seconds while recording and played
+// back with Catmull-Rom splines through the keys, so the motion stays smooth
+// between them. Playback only depends on the time asked for, so the same
+// path drives the same fly-through on every run, e.g. for comparing frame
+// times. Stored as a small header and 28 bytes per key, host byte order.
+class CameraPath
+{
+public:
+    struct Key
+    {
+        float time;
+        glm::vec3 position;
+        float yaw;
+        float pitch;
+        float zoom;
+    };
+
+    // seconds between recorded keys; 0 keeps every one
+    explicit CameraPath(float keyInterval = 0.1f) : keyInterval(keyInterval) {}
+
+    void clear() { keys.clear(); }
+
+    // times must increase; keys closer than keyInterval to the last one are dropped,
+    // with a little slack so steps that add up to exactly keyInterval are kept
+    void add(float time, const Camera &camera)
+    {
+        if (!keys.empty() && time - keys.back().time < keyInterval * 0.999f)
+            return;
+        Key key;
+        key.time = time;
+        key.position = camera.Position;
+        key.yaw = camera.Yaw;
+        key.pitch = camera.Pitch;
+        key.zoom = camera.Zoom;
+        keys.push_back(key);
+    }
+
+    size_t size() const { return keys.size(); }
+    const Key& operator[](size_t i) const { return keys[i]; }
+    float duration() const { return keys.empty() ? 0.0f : keys.back().time; }
+
+    // the pose at time, clamped to the first and last key
+    Key sample(float time) const
+    {
+        if (keys.size() < 2)
+            return keys.empty() ? Key() : keys[0];
+        if (time <= keys.front().time)
+            return keys.front();
+        if (time >= keys.back().time)
+            return keys.back();
+        // the segment keys[i] .. keys[i + 1] containing time, with its outer neighbours clamped at the ends
+        size_t i = std::upper_bound(keys.begin(), keys.end(), time, [](float t, const Key &key) { return t < key.time; }) - keys.begin() - 1;
+        const Key &k0 = keys[i > 0 ? i - 1 : 0];
+        const Key &k1 = keys[i];
+        const Key &k2 = keys[i + 1];
+        const Key &k3 = keys[i + 2 < keys.size() ? i + 2 : i + 1];
+        float s = (time - k1.time) / (k2.time - k1.time);
+
+        Key key;
+        key.time = time;
+        key.position = glm::catmullRom(k0.position, k1.position, k2.position, k3.position, s);
+        // yaw is never wrapped, so the angles interpolate like any other value
+        glm::vec3 angles = glm::catmullRom(glm::vec3(k0.yaw, k0.pitch, k0.zoom), glm::vec3(k1.yaw, k1.pitch, k1.zoom),
+                                           glm::vec3(k2.yaw, k2.pitch, k2.zoom), glm::vec3(k3.yaw, k3.pitch, k3.zoom), s);
+        key.yaw = angles.x;
+        key.pitch = glm::clamp(angles.y, -89.0f, 89.0f);
+        key.zoom = glm::clamp(angles.z, 1.0f, 45.0f);
+        return key;
+    }
+
+    void apply(float time, Camera &camera) const
+    {
+        if (keys.empty())
+            return;
+        Key key = sample(time);
+        camera.SetPose(key.position, key.yaw, key.pitch, key.zoom);
+    }
+
+    bool save(const std::string &path) const
+    {
+        FILE *file = fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            std::cout << "ERROR::CAMERA_PATH::CANNOT_WRITE " << path << std::endl;
+            return false;
+        }
+        Header header;
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.count = (uint32_t)keys.size();
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+        for (size_t i = 0; ok && i < keys.size(); i++)
+        {
+            float record[FLOATS_PER_KEY];
+            encode(keys[i], record);
+            ok = fwrite(record, sizeof(record), 1, file) == 1;
+        }
+        ok = fclose(file) == 0 && ok;
+        if (!ok)
+            std::cout << "ERROR::CAMERA_PATH::CANNOT_WRITE " << path << std::endl;
+        return ok;
+    }
+
+    bool load(const std::string &path)
+    {
+        keys.clear();
+        FILE *file = fopen(path.c_str(), "rb");
+        if (!file)
+        {
+            std::cout << "ERROR::CAMERA_PATH::CANNOT_READ " << path << std::endl;
+            return false;
+        }
+        Header header;
+        bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == MAGIC && header.version == VERSION;
+        // a corrupt count must not size the vector; the keys have to be there
+        ok = ok && endsAfter(file, (uint64_t)header.count * FLOATS_PER_KEY * sizeof(float));
+        if (ok)
+        {
+            keys.resize(header.count);
+            for (size_t i = 0; ok && i < keys.size(); i++)
+            {
+                float record[FLOATS_PER_KEY];
+                ok = fread(record, sizeof(record), 1, file) == 1;
+                if (ok)
+                    decode(record, keys[i]);
+                // sample() relies on increasing times
+                ok = ok && (i == 0 || keys[i].time > keys[i - 1].time);
+            }
+        }
+        fclose(file);
+        if (!ok)
+        {
+            std::cout << "ERROR::CAMERA_PATH::INVALID " << path << std::endl;
+            keys.clear();
+        }
+        return ok;
+    }
+
+private:
+    static const uint32_t MAGIC = 0x48545043; // "CPTH"
+    // bump when the key layout changes
+    static const uint32_t VERSION = 1;
+    // time, position, yaw, pitch, zoom
+    static const size_t FLOATS_PER_KEY = 7;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t count;
+    };
+
+    float keyInterval;
+    std::vector<Key> keys;
+
+    // true when exactly bytes remain after the read position
+    static bool endsAfter(FILE *file, uint64_t bytes)
+    {
+        long start = ftell(file);
+        if (start < 0 || fseek(file, 0, SEEK_END) != 0)
+            return false;
+        long end = ftell(file);
+        return fseek(file, start, SEEK_SET) == 0 && end >= start && (uint64_t)(end - start) == bytes;
+    }
+
+    static void encode(const Key &key, float *record)
+    {
+        record[0] = key.time;
+        record[1] = key.position.x;
+        record[2] = key.position.y;
+        record[3] = key.position.z;
+        record[4] = key.yaw;
+        record[5] = key.pitch;
+        record[6] = key.zoom;
+    }
+
+    static void decode(const float *record, Key &key)
+    {
+        key.time = record[0];
+        key.position = glm::vec3(record[1], record[2], record[3]);
+        key.yaw = record[4];
+        key.pitch = record[5];
+        key.zoom = record[6];
+    }
+};
+
+#endif
@@ -0,0 +1,119 @@
+//
+//  CubeTransforms.h
+//  MyOpenGLPro7
+//
+
+#ifndef CUBE_TRANSFORMS_H
+#define CUBE_TRANSFORMS_H
+
+#include "../glm/glm/glm.hpp"
+#include "../glm/glm/gtc/matrix_transform.hpp"
+#include "JobSystem.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Spinning cubes kept as structure-of-arrays: every field in its own tightly
+// packed array, so a chunk of cubes reads only what it needs (culling reads
+// x/y/z/radius straight from here). update() fills the model matrices in
+// parallel straight into one contiguous array, in the order the render
+// thread asked for.
+class CubeTransforms
+{
+public:
+    // how many cubes one job handles; big enough to amortise the hand-off
+    static const size_t GRAIN = 1024;
+
+    // all cubes spin around the same axis, as in the original scene
+    explicit CubeTransforms(const glm::vec3 &axis = glm::vec3(1.0f, 0.3f, 0.5f)) : axis(glm::normalize(axis)) {}
+
+    // spin is in radians per second; the default radius bounds a unit cube however it turns
+    void add(const glm::vec3 &position, float spin, float radius = 0.8660254f)
+    {
+        x.push_back(position.x);
+        y.push_back(position.y);
+        z.push_back(position.z);
+        radii.push_back(radius);
+        spins.push_back(spin);
+    }
+
+    size_t size() const { return spins.size(); }
+
+    // translate(position) * rotate(time * spin, axis) for every cube
+    void update(JobSystem &jobs, float time)
+    {
+        models.resize(size());
+        jobs.parallelFor(size(), GRAIN, [this, time](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                models[i] = compute(i, time);
+        });
+    }
+
+    // only the listed cubes, e.g. the ones that survived culling, packed in list order
+    void update(JobSystem &jobs, float time, const std::vector<uint32_t> &selected)
+    {
+        models.resize(selected.size());
+        jobs.parallelFor(selected.size(), GRAIN, [this, time, &selected](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                models[i] = compute(selected[i], time);
+        });
+    }
+
+    // the listed cubes at two points in time, for blending between simulation steps
+    void update(JobSystem &jobs, float previousTime, float time, const std::vector<uint32_t> &selected)
+    {
+        previousModels.resize(selected.size());
+        models.resize(selected.size());
+        jobs.parallelFor(selected.size(), GRAIN, [this, previousTime, time, &selected](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                previousModels[i] = compute(selected[i], previousTime);
+                models[i] = compute(selected[i], time);
+            }
+        });
+    }
+
+    // a single cube's matrix, e.g. for picking
+    glm::mat4 model(size_t i, float time) const { return compute(i, time); }
+
+    // the matrices written by the last update, contiguous and ready for upload
+    const glm::mat4* data() const { return models.empty() ? NULL : &models[0]; }
+    size_t modelCount() const { return models.size(); }
+    // the earlier matrices of the two-time update, same order and count
+    const glm::mat4* previousData() const { return previousModels.empty() ? NULL : &previousModels[0]; }
+
+    // bounding spheres for culling
+    const float* positionsX() const { return x.empty() ? NULL : &x[0]; }
+    const float* positionsY() const { return y.empty() ? NULL : &y[0]; }
+    const float* positionsZ() const { return z.empty() ? NULL : &z[0]; }
+    const float* boundingRadii() const { return radii.empty() ? NULL : &radii[0]; }
+
+private:
+    glm::vec3 axis;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> radii;
+    std::vector<float> spins;
+    std::vector<glm::mat4> models;
+    std::vector<glm::mat4> previousModels;
+
+    // glm::rotate written out for the fixed, already normalised axis
+    glm::mat4 compute(size_t i, float time) const
+    {
+        float angle = time * spins[i];
+        float c = std::cos(angle);
+        float s = std::sin(angle);
+        glm::vec3 t = (1.0f - c) * axis;
+
+        glm::mat4 m;
+        m[0] = glm::vec4(c + t.x * axis.x, t.x * axis.y + s * axis.z, t.x * axis.z - s * axis.y, 0.0f);
+        m[1] = glm::vec4(t.y * axis.x - s * axis.z, c + t.y * axis.y, t.y * axis.z + s * axis.x, 0.0f);
+        m[2] = glm::vec4(t.z * axis.x + s * axis.y, t.z * axis.y - s * axis.x, c + t.z * axis.z, 0.0f);
+        m[3] = glm::vec4(x[i], y[i], z[i], 1.0f);
+        return m;
+    }
+};
+
+#endif
@@ -0,0 +1,183 @@
+//
+//  FileWatcher.h
+//  MyOpenGLPro7
+//
+
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#elif defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/event.h>
+#endif
+
+// Watches files from a background thread and calls back (on that thread) with
+// the ones whose modification time or size changed. The thread sleeps in
+// inotify (Linux) or kqueue (macOS) on the files' directories, which wakes it
+// as soon as an editor saves; every wake, and at the latest every POLL_MS,
+// the watched files are re-stat'ed, so in-place writes are never missed.
+class FileWatcher
+{
+public:
+    typedef std::function<void(const std::vector<std::string> &changed)> Callback;
+
+    static const int POLL_MS = 250;
+    static const int SETTLE_MS = 20;
+
+    explicit FileWatcher(Callback onChange) : onChange(onChange), running(true)
+    {
+#if defined(__linux__)
+        notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#elif defined(__APPLE__)
+        notifyFd = kqueue();
+#endif
+        thread = std::thread(&FileWatcher::run, this);
+    }
+
+    ~FileWatcher()
+    {
+        running = false;
+        thread.join();
+#if defined(__APPLE__)
+        for (size_t i = 0; i < directoryFds.size(); i++)
+            close(directoryFds[i]);
+#endif
+        if (notifyFd >= 0)
+            close(notifyFd);
+    }
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // safe to call from any thread, watching a file twice is harmless
+    void watch(const std::string &path)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (files.count(path))
+            return;
+        files[path] = stamp(path);
+
+        size_t slash = path.find_last_of('/');
+        std::string directory = slash == std::string::npos ? "." : path.substr(0, slash);
+        if (!directories.insert(directory).second || notifyFd < 0)
+            return;
+#if defined(__linux__)
+        inotify_add_watch(notifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY);
+#elif defined(__APPLE__)
+        int fd = open(directory.c_str(), O_EVTONLY);
+        if (fd >= 0)
+        {
+            struct kevent change;
+            EV_SET(&change, fd, EVFILT_VNODE, EV_ADD | EV_CLEAR, NOTE_WRITE | NOTE_EXTEND | NOTE_ATTRIB, 0, NULL);
+            kevent(notifyFd, &change, 1, NULL, 0, NULL);
+            directoryFds.push_back(fd);
+        }
+#endif
+    }
+
+private:
+    struct Stamp
+    {
+        long long mtime;
+        long long size;
+        bool operator!=(const Stamp &other) const { return mtime != other.mtime || size != other.size; }
+    };
+
+    Callback onChange;
+    std::atomic<bool> running;
+    std::thread thread;
+    std::mutex mutex;
+    std::map<std::string, Stamp> files;
+    std::set<std::string> directories;
+    int notifyFd = -1;
+#if defined(__APPLE__)
+    std::vector<int> directoryFds;
+#endif
+
+    static Stamp stamp(const std::string &path)
+    {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0)
+            return Stamp{-1, -1};
+#if defined(__APPLE__)
+        long long ns = (long long)info.st_mtimespec.tv_sec * 1000000000ll + info.st_mtimespec.tv_nsec;
+#else
+        long long ns = (long long)info.st_mtim.tv_sec * 1000000000ll + info.st_mtim.tv_nsec;
+#endif
+        return Stamp{ns, (long long)info.st_size};
+    }
+
+    // block until the OS reports activity in a watched directory or POLL_MS passes
+    void wait()
+    {
+        bool woken = false;
+#if defined(__linux__)
+        if (notifyFd >= 0)
+        {
+            struct pollfd fds = {notifyFd, POLLIN, 0};
+            if (poll(&fds, 1, POLL_MS) > 0)
+            {
+                char events[4096];
+                while (read(notifyFd, events, sizeof(events)) > 0)
+                    ;
+                woken = true;
+            }
+        }
+        else
+#elif defined(__APPLE__)
+        if (notifyFd >= 0)
+        {
+            struct kevent events[8];
+            struct timespec timeout = {0, POLL_MS * 1000000L};
+            woken = kevent(notifyFd, NULL, 0, events, 8, &timeout) > 0;
+        }
+        else
+#endif
+        std::this_thread::sleep_for(std::chrono::milliseconds((long long)POLL_MS));
+        // editors often truncate then write; give the save a moment to land
+        if (woken)
+            std::this_thread::sleep_for(std::chrono::milliseconds((long long)SETTLE_MS));
+    }
+
+    void run()
+    {
+        while (running)
+        {
+            wait();
+            std::vector<std::string> changed;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (std::map<std::string, Stamp>::iterator it = files.begin(); it != files.end(); ++it)
+                {
+                    Stamp now = stamp(it->first);
+                    if (now != it->second)
+                    {
+                        it->second = now;
+                        // a missing or truncated file is mid-save, wait for the rest
+                        if (now.size > 0)
+                            changed.push_back(it->first);
+                    }
+                }
+            }
+            if (!changed.empty() && running)
+                onChange(changed);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,89 @@
+//
+//  FrameConstants.h
+//  MyOpenGLPro7
+//
+
+#ifndef FRAME_CONSTANTS_H
+#define FRAME_CONSTANTS_H
+
+#include <glad/glad.h>
+#include "../glm/glm/glm.hpp"
+#include "Shader.h"
+#include "GLStateCache.h"
+#include "StreamBuffer.h"
+
+#include <cstring>
+
+// CPU copy of the std140 "PerFrame" uniform block declared in perframe.glsl.
+// vec3 + float share one 16 byte slot, so the members match std140 as is.
+struct PerFrameData
+{
+    glm::mat4 view;
+    glm::mat4 project;
+    glm::mat4 viewProject;
+    glm::vec3 cameraPos;
+    float time;
+};
+static_assert(sizeof(PerFrameData) == 208, "PerFrameData must match the std140 PerFrame block");
+
+// Uploads the per-frame camera data once per frame into a StreamBuffer ring
+// of uniform buffer slots; every attached shader reads it through the same binding point.
+class FrameConstants
+{
+public:
+    // uniform buffer binding point of the PerFrame block
+    static const GLuint BINDING = 0;
+
+    FrameConstants() : stream(GL_UNIFORM_BUFFER)
+    {
+        GLint offsetAlignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+        alignment = offsetAlignment;
+        stream.reserve(((GLsizeiptr)sizeof(PerFrameData) + alignment - 1) / alignment * alignment);
+    }
+
+    FrameConstants(const FrameConstants&) = delete;
+    FrameConstants& operator=(const FrameConstants&) = delete;
+
+    // route the shader's PerFrame block to our binding point
+    void attach(Shader &shader) const
+    {
+        shader.bindUniformBlock("PerFrame", BINDING);
+    }
+
+    // write this frame's slot and bind it; call before the frame's draws
+    void update(const glm::mat4 &view, const glm::mat4 &project, const glm::vec3 &cameraPos, float time)
+    {
+        PerFrameData data;
+        data.view = view;
+        data.project = project;
+        data.viewProject = project * view;
+        data.cameraPos = cameraPos;
+        data.time = time;
+
+        StreamBuffer::Allocation slot = stream.allocate(sizeof(data), alignment);
+        if (!slot.data)
+            return;
+        memcpy(slot.data, &data, sizeof(data));
+        stream.commit(slot);
+        glState().bindBufferRange(GL_UNIFORM_BUFFER, BINDING, stream.buffer(), slot.offset, sizeof(data));
+    }
+
+    // fence the slot written by update(); call after the frame's draws
+    void endFrame()
+    {
+        stream.endFrame();
+    }
+
+    // must run while the context is still alive
+    void release()
+    {
+        stream.release();
+    }
+
+private:
+    StreamBuffer stream;
+    GLsizeiptr alignment = 256;
+};
+
+#endif
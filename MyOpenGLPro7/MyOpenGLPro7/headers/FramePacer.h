@@ -0,0 +1,222 @@
+//
+//  FramePacer.h
+//  MyOpenGLPro7
+//
+
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "StreamBuffer.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+
+// Keeps the CPU from running ahead of the GPU and the display:
+// - the swap interval: immediate, vsync, or adaptive vsync (tears instead of
+//   halving the rate when a frame is late) where the driver offers it
+// - at most framesInFlight frames queued: beginFrame() waits on the fence of
+//   the frame that many frames back, so input sampled after it is never
+//   older than that on screen
+// - an optional target rate: beginFrame() sleeps until the frame's deadline
+// Every frame's CPU time, GPU time (GL_TIME_ELAPSED, read back a few frames
+// later without stalling), frame time and time spent waiting go into a ring
+// of the last HISTORY frames.
+class FramePacer
+{
+public:
+    enum SwapMode {
+        SWAP_IMMEDIATE,
+        SWAP_VSYNC,
+        SWAP_ADAPTIVE
+    };
+
+    struct FrameTiming
+    {
+        uint64_t frame = 0;
+        // from the end of beginFrame() to endFrame()
+        float cpuMs = 0.0f;
+        // negative until the query result arrived
+        float gpuMs = -1.0f;
+        // from one beginFrame() to the next
+        float frameMs = 0.0f;
+        // blocked in beginFrame() on the deadline or a fence
+        float waitMs = 0.0f;
+    };
+
+    static const int MAX_FRAMES_IN_FLIGHT = 4;
+    static const int HISTORY = 128;
+
+    explicit FramePacer(int framesInFlight = 2)
+    {
+        inFlight = framesInFlight < 1 ? 1 : framesInFlight > MAX_FRAMES_IN_FLIGHT ? MAX_FRAMES_IN_FLIGHT : framesInFlight;
+        for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+            fences[i] = 0;
+        glGenQueries(QUERIES, queries);
+        for (int i = 0; i < QUERIES; i++)
+            queryFrames[i] = NO_FRAME;
+        lastBegin = Clock::now();
+    }
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    // needs the window's context current; returns the mode actually set
+    SwapMode setSwapMode(SwapMode mode)
+    {
+        // a negative interval is adaptive vsync, only valid with the swap_control_tear extensions
+        if (mode == SWAP_ADAPTIVE && !glfwExtensionSupported("WGL_EXT_swap_control_tear")
+            && !glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+            mode = SWAP_VSYNC;
+        glfwSwapInterval(mode == SWAP_IMMEDIATE ? 0 : mode == SWAP_VSYNC ? 1 : -1);
+        swapMode = mode;
+        return mode;
+    }
+
+    // frames per second to hold, 0 for as fast as the swap interval allows
+    void setTargetFps(double fps)
+    {
+        targetInterval = fps > 0.0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps)) : Clock::duration::zero();
+        deadline = Clock::now();
+    }
+
+    // call first thing in the frame, before sampling input
+    void beginFrame()
+    {
+        Clock::time_point waitStart = Clock::now();
+        if (targetInterval > Clock::duration::zero())
+        {
+            deadline += targetInterval;
+            // fell behind by more than a frame: start over rather than rushing to catch up
+            if (deadline < waitStart)
+                deadline = waitStart;
+            std::this_thread::sleep_until(deadline);
+        }
+        // the frame inFlight frames back must be done before this one starts
+        StreamBuffer::waitFence(fences[frame % inFlight]);
+        collectQueries();
+
+        Clock::time_point now = Clock::now();
+        FrameTiming &timing = history[frame % HISTORY];
+        timing = FrameTiming();
+        timing.frame = frame;
+        timing.waitMs = milliseconds(now - waitStart);
+        timing.frameMs = milliseconds(now - lastBegin);
+        lastBegin = now;
+        workStart = now;
+
+        int query = (int)(frame % QUERIES);
+        if (queryFrames[query] == NO_FRAME)
+        {
+            glBeginQuery(GL_TIME_ELAPSED, queries[query]);
+            queryFrames[query] = frame;
+            queryOpen = true;
+        }
+    }
+
+    // call after the frame's last GL command, right before swapping
+    void endFrame()
+    {
+        if (queryOpen)
+        {
+            glEndQuery(GL_TIME_ELAPSED);
+            queryOpen = false;
+        }
+        fences[frame % inFlight] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        history[frame % HISTORY].cpuMs = milliseconds(Clock::now() - workStart);
+        frame++;
+    }
+
+    SwapMode mode() const { return swapMode; }
+    uint64_t frameCount() const { return frame; }
+
+    // framesAgo 0 is the last finished frame; its GPU time may still be pending
+    const FrameTiming& timing(size_t framesAgo) const { return history[(frame - 1 - framesAgo) % HISTORY]; }
+    size_t historySize() const { return frame < (uint64_t)HISTORY ? (size_t)frame : (size_t)HISTORY; }
+
+    void report() const
+    {
+        size_t count = historySize();
+        if (count == 0)
+            return;
+        float cpu = 0.0f, gpu = 0.0f, frameTime = 0.0f, wait = 0.0f, worst = 0.0f;
+        size_t gpuCount = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            const FrameTiming &t = timing(i);
+            cpu += t.cpuMs;
+            frameTime += t.frameMs;
+            wait += t.waitMs;
+            worst = t.frameMs > worst ? t.frameMs : worst;
+            if (t.gpuMs >= 0.0f)
+            {
+                gpu += t.gpuMs;
+                gpuCount++;
+            }
+        }
+        std::cout << "FRAME::PACING last " << count << " frames: frame " << frameTime / count << " ms (worst " << worst
+                  << "), cpu " << cpu / count << " ms, gpu " << (gpuCount ? gpu / gpuCount : 0.0f) << " ms, waiting "
+                  << wait / count << " ms" << std::endl;
+    }
+
+    // must run while the context is still alive
+    void release()
+    {
+        for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+            StreamBuffer::waitFence(fences[i]);
+        if (queryOpen)
+            glEndQuery(GL_TIME_ELAPSED);
+        queryOpen = false;
+        glDeleteQueries(QUERIES, queries);
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+    // enough queries that results are usually in before a query is reused
+    static const int QUERIES = MAX_FRAMES_IN_FLIGHT + 2;
+    static const uint64_t NO_FRAME = ~(uint64_t)0;
+
+    int inFlight;
+    SwapMode swapMode = SWAP_VSYNC;
+    GLsync fences[MAX_FRAMES_IN_FLIGHT];
+    GLuint queries[QUERIES];
+    // the frame each query measures, NO_FRAME while free
+    uint64_t queryFrames[QUERIES];
+    bool queryOpen = false;
+    uint64_t frame = 0;
+    Clock::duration targetInterval = Clock::duration::zero();
+    Clock::time_point deadline;
+    Clock::time_point lastBegin;
+    Clock::time_point workStart;
+    FrameTiming history[HISTORY];
+
+    static float milliseconds(Clock::duration duration)
+    {
+        return std::chrono::duration<float, std::milli>(duration).count();
+    }
+
+    // read whatever results are ready, without waiting for the rest
+    void collectQueries()
+    {
+        for (int i = 0; i < QUERIES; i++)
+        {
+            if (queryFrames[i] == NO_FRAME)
+                continue;
+            GLint available = 0;
+            glGetQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                continue;
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &nanoseconds);
+            // the ring may have moved past this frame already
+            if (frame - queryFrames[i] < (uint64_t)HISTORY)
+                history[queryFrames[i] % HISTORY].gpuMs = (float)(nanoseconds / 1.0e6);
+            queryFrames[i] = NO_FRAME;
+        }
+    }
+};
+
+#endif
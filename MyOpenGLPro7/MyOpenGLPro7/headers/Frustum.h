@@ -0,0 +1,164 @@
+//
+//  Frustum.h
+//  MyOpenGLPro7
+//
+
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include "../glm/glm/glm.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define FRUSTUM_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define FRUSTUM_NEON 1
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// The six planes of a view volume, pointing inwards, as (normal, distance)
+// with unit normals, so plane . (p, 1) is the signed distance of p.
+struct Frustum
+{
+    enum { LEFT, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE, PLANE_COUNT };
+    glm::vec4 planes[PLANE_COUNT];
+
+    // Gribb/Hartmann: every plane is the last row of project * view plus or
+    // minus one of the others (GL's -1..1 depth range). With reversedDepth
+    // the depth range is 1 (near) to 0 (far) as set up by glClipControl; an
+    // infinite far plane comes out as one every point is inside of.
+    static Frustum fromMatrix(const glm::mat4 &viewProject, bool reversedDepth = false)
+    {
+        glm::vec4 row[4];
+        for (int i = 0; i < 4; i++)
+            row[i] = glm::vec4(viewProject[0][i], viewProject[1][i], viewProject[2][i], viewProject[3][i]);
+        Frustum frustum;
+        frustum.planes[LEFT] = row[3] + row[0];
+        frustum.planes[RIGHT] = row[3] - row[0];
+        frustum.planes[BOTTOM] = row[3] + row[1];
+        frustum.planes[TOP] = row[3] - row[1];
+        frustum.planes[NEAR_PLANE] = reversedDepth ? row[3] - row[2] : row[3] + row[2];
+        frustum.planes[FAR_PLANE] = reversedDepth ? row[2] : row[3] - row[2];
+        for (int p = 0; p < PLANE_COUNT; p++)
+        {
+            float length = glm::length(glm::vec3(frustum.planes[p]));
+            frustum.planes[p] = length > 0.0f ? frustum.planes[p] / length : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        }
+        return frustum;
+    }
+
+    bool intersectsSphere(const glm::vec3 &center, float radius) const
+    {
+        for (int p = 0; p < PLANE_COUNT; p++)
+            if (glm::dot(glm::vec3(planes[p]), center) + planes[p].w < -radius)
+                return false;
+        return true;
+    }
+
+    bool intersectsBox(const glm::vec3 &minimum, const glm::vec3 &maximum) const
+    {
+        for (int p = 0; p < PLANE_COUNT; p++)
+        {
+            // the corner furthest along the plane normal
+            glm::vec3 normal(planes[p]);
+            glm::vec3 corner(normal.x >= 0.0f ? maximum.x : minimum.x,
+                             normal.y >= 0.0f ? maximum.y : minimum.y,
+                             normal.z >= 0.0f ? maximum.z : minimum.z);
+            if (glm::dot(normal, corner) + planes[p].w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+};
+
+// appends first + the lane of every bit set in mask, lowest lane first
+inline void appendLanes(unsigned int mask, size_t first, std::vector<uint32_t> &visible)
+{
+    while (mask)
+    {
+#ifdef _MSC_VER
+        unsigned long lane;
+        _BitScanForward(&lane, mask);
+#else
+        int lane = __builtin_ctz(mask);
+#endif
+        visible.push_back((uint32_t)(first + lane));
+        mask &= mask - 1;
+    }
+}
+
+// Tests bounding spheres stored as separate x/y/z/radius arrays against a
+// frustum, four at a time with SSE or NEON, and appends the indices of the
+// ones that are at least partly inside. Conservative: a sphere near a frustum
+// corner may pass although it is outside, which only costs a draw.
+inline void cullSpheres(const Frustum &frustum, const float *x, const float *y, const float *z, const float *radius,
+                        size_t count, std::vector<uint32_t> &visible)
+{
+    visible.clear();
+    size_t i = 0;
+#ifdef FRUSTUM_SSE
+    __m128 planeX[Frustum::PLANE_COUNT], planeY[Frustum::PLANE_COUNT], planeZ[Frustum::PLANE_COUNT], planeW[Frustum::PLANE_COUNT];
+    for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+    {
+        planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+        planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+        planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+        planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+    }
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 cx = _mm_loadu_ps(x + i);
+        __m128 cy = _mm_loadu_ps(y + i);
+        __m128 cz = _mm_loadu_ps(z + i);
+        __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+        __m128 inside = _mm_cmpeq_ps(cx, cx);
+        for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)),
+                                         _mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+        }
+        appendLanes((unsigned int)_mm_movemask_ps(inside), i, visible);
+    }
+#elif defined(FRUSTUM_NEON)
+    float32x4_t planeX[Frustum::PLANE_COUNT], planeY[Frustum::PLANE_COUNT], planeZ[Frustum::PLANE_COUNT], planeW[Frustum::PLANE_COUNT];
+    for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+    {
+        planeX[p] = vdupq_n_f32(frustum.planes[p].x);
+        planeY[p] = vdupq_n_f32(frustum.planes[p].y);
+        planeZ[p] = vdupq_n_f32(frustum.planes[p].z);
+        planeW[p] = vdupq_n_f32(frustum.planes[p].w);
+    }
+    // NEON has no movemask: keep one bit per lane and add the lanes up
+    const uint32_t bits[4] = { 1, 2, 4, 8 };
+    const uint32x4_t laneBits = vld1q_u32(bits);
+    for (; i + 4 <= count; i += 4)
+    {
+        float32x4_t cx = vld1q_f32(x + i);
+        float32x4_t cy = vld1q_f32(y + i);
+        float32x4_t cz = vld1q_f32(z + i);
+        float32x4_t negativeRadius = vnegq_f32(vld1q_f32(radius + i));
+        uint32x4_t inside = vdupq_n_u32(0xFFFFFFFFu);
+        for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+        {
+            float32x4_t distance = vaddq_f32(vaddq_f32(vmulq_f32(planeX[p], cx), vmulq_f32(planeY[p], cy)),
+                                             vaddq_f32(vmulq_f32(planeZ[p], cz), planeW[p]));
+            inside = vandq_u32(inside, vcgeq_f32(distance, negativeRadius));
+        }
+        uint32x4_t set = vandq_u32(inside, laneBits);
+        uint32x2_t halves = vadd_u32(vget_low_u32(set), vget_high_u32(set));
+        appendLanes(vget_lane_u32(vpadd_u32(halves, halves), 0), i, visible);
+    }
+#endif
+    for (; i < count; i++)
+        if (frustum.intersectsSphere(glm::vec3(x[i], y[i], z[i]), radius[i]))
+            visible.push_back((uint32_t)i);
+}
+
+#endif
@@ -0,0 +1,136 @@
+//
+//  GLExtensions.h
+//  MyOpenGLPro7
+//
+
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <glad/glad.h>
+
+#include <cstring>
+
+// glad is generated for the 3.3 core profile, so anything newer is loaded here
+// at runtime. Every pointer may stay NULL (macOS stops at 4.1), callers must
+// check the has*() helpers and fall back to a 3.3 path.
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_DYNAMIC_STORAGE_BIT
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#endif
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_LOWER_LEFT
+#define GL_LOWER_LEFT 0x8CA1
+#endif
+#ifndef GL_NEGATIVE_ONE_TO_ONE
+#define GL_NEGATIVE_ONE_TO_ONE 0x935E
+#endif
+#ifndef GL_ZERO_TO_ONE
+#define GL_ZERO_TO_ONE 0x935F
+#endif
+
+typedef void (APIENTRYP GLExtBufferStorageProc)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+typedef void (APIENTRYP GLExtGetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP GLExtProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRYP GLExtProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP GLExtMaxShaderCompilerThreadsProc)(GLuint count);
+typedef void (APIENTRYP GLExtMultiDrawElementsIndirectProc)(GLenum mode, GLenum type, const void *indirect, GLsizei drawcount, GLsizei stride);
+typedef void (APIENTRYP GLExtClipControlProc)(GLenum origin, GLenum depth);
+
+struct GLExtensions
+{
+    int major = 0;
+    int minor = 0;
+
+    GLExtBufferStorageProc BufferStorage = NULL;
+    GLExtGetProgramBinaryProc GetProgramBinary = NULL;
+    GLExtProgramBinaryProc ProgramBinary = NULL;
+    GLExtProgramParameteriProc ProgramParameteri = NULL;
+    GLExtMaxShaderCompilerThreadsProc MaxShaderCompilerThreads = NULL;
+    GLExtMultiDrawElementsIndirectProc MultiDrawElementsIndirect = NULL;
+    GLExtClipControlProc ClipControl = NULL;
+
+    // GL 4.4 or ARB_buffer_storage: persistently mapped buffers
+    bool hasBufferStorage() const { return BufferStorage != NULL; }
+    // GL 4.1 or ARB_get_program_binary: save and reload linked programs
+    bool hasProgramBinary() const { return GetProgramBinary && ProgramBinary && ProgramParameteri; }
+    // KHR/ARB_parallel_shader_compile: GL_COMPLETION_STATUS_KHR can be polled without blocking
+    bool hasParallelShaderCompile() const { return MaxShaderCompilerThreads != NULL; }
+    // GL 4.3 or ARB_multi_draw_indirect: many indexed draws from one buffer of commands
+    bool hasMultiDrawIndirect() const { return MultiDrawElementsIndirect != NULL; }
+    // GL 4.5 or ARB_clip_control: a 0..1 clip depth range, which reverse-Z needs
+    bool hasClipControl() const { return ClipControl != NULL; }
+
+    bool versionAtLeast(int wantMajor, int wantMinor) const
+    {
+        return major > wantMajor || (major == wantMajor && minor >= wantMinor);
+    }
+};
+
+// the single set of entry points for the current context
+inline GLExtensions& glExt()
+{
+    static GLExtensions extensions;
+    return extensions;
+}
+
+inline bool hasGLExtension(const char *name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++)
+    {
+        const char *ext = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if (ext && strcmp(ext, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+// call once after gladLoadGLLoader with the same loader
+inline void loadGLExtensions(GLADloadproc load)
+{
+    GLExtensions &ext = glExt();
+    glGetIntegerv(GL_MAJOR_VERSION, &ext.major);
+    glGetIntegerv(GL_MINOR_VERSION, &ext.minor);
+
+    if (ext.versionAtLeast(4, 4) || hasGLExtension("GL_ARB_buffer_storage"))
+        ext.BufferStorage = (GLExtBufferStorageProc)load("glBufferStorage");
+    if (ext.versionAtLeast(4, 1) || hasGLExtension("GL_ARB_get_program_binary"))
+    {
+        ext.GetProgramBinary = (GLExtGetProgramBinaryProc)load("glGetProgramBinary");
+        ext.ProgramBinary = (GLExtProgramBinaryProc)load("glProgramBinary");
+        ext.ProgramParameteri = (GLExtProgramParameteriProc)load("glProgramParameteri");
+    }
+    if (hasGLExtension("GL_KHR_parallel_shader_compile"))
+        ext.MaxShaderCompilerThreads = (GLExtMaxShaderCompilerThreadsProc)load("glMaxShaderCompilerThreadsKHR");
+    else if (hasGLExtension("GL_ARB_parallel_shader_compile"))
+        ext.MaxShaderCompilerThreads = (GLExtMaxShaderCompilerThreadsProc)load("glMaxShaderCompilerThreadsARB");
+    // the commands' baseInstance is only honoured with GL 4.2 / ARB_base_instance
+    bool baseInstance = ext.versionAtLeast(4, 2) || hasGLExtension("GL_ARB_base_instance");
+    if (ext.versionAtLeast(4, 3) || (baseInstance && hasGLExtension("GL_ARB_multi_draw_indirect")))
+        ext.MultiDrawElementsIndirect = (GLExtMultiDrawElementsIndirectProc)load("glMultiDrawElementsIndirect");
+    if (ext.versionAtLeast(4, 5) || hasGLExtension("GL_ARB_clip_control"))
+        ext.ClipControl = (GLExtClipControlProc)load("glClipControl");
+}
+
+#endif
@@ -0,0 +1,364 @@
+//
+//  GLStateCache.h
+//  MyOpenGLPro7
+//
+
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+#include <glad/glad.h>
+#include "GLExtensions.h"
+
+#include <cstring>
+
+// what a call through GLStateCache was for, to split the counters
+enum GLStateCall {
+    STATE_PROGRAM,
+    STATE_VERTEX_ARRAY,
+    STATE_ACTIVE_TEXTURE,
+    STATE_TEXTURE,
+    STATE_BUFFER,
+    STATE_BUFFER_RANGE,
+    STATE_CAPABILITY,
+    STATE_BLEND_FUNC,
+    STATE_DEPTH_FUNC,
+    STATE_DEPTH_MASK,
+    STATE_POLYGON_MODE,
+    STATE_CALL_COUNT
+};
+
+// Shadows the bind points and fixed-function state the renderer touches and
+// drops calls that would set what is already set. Everything starts out
+// unknown, so the first call of each kind always reaches the driver; after
+// anything changes state behind the cache's back, call invalidate().
+// It only works if all code sets these through the cache, and only for the
+// context that was current when it was filled.
+class GLStateCache
+{
+public:
+    static const int MAX_TEXTURE_UNITS = 32;
+    static const int MAX_BUFFER_RANGES = 16;
+
+    struct Stats
+    {
+        unsigned int issued[STATE_CALL_COUNT];
+        unsigned int elided[STATE_CALL_COUNT];
+
+        unsigned int totalIssued() const { return sum(issued); }
+        unsigned int totalElided() const { return sum(elided); }
+
+    private:
+        static unsigned int sum(const unsigned int *counts)
+        {
+            unsigned int total = 0;
+            for (int i = 0; i < STATE_CALL_COUNT; i++)
+                total += counts[i];
+            return total;
+        }
+    };
+
+    GLStateCache()
+    {
+        invalidate();
+        resetStats();
+    }
+
+    // forget everything, the next call of each kind goes to the driver
+    void invalidate()
+    {
+        program = UNKNOWN;
+        vertexArray = UNKNOWN;
+        activeUnit = UNKNOWN;
+        for (int u = 0; u < MAX_TEXTURE_UNITS; u++)
+            for (int t = 0; t < TEXTURE_TARGETS; t++)
+                textures[u][t] = UNKNOWN;
+        for (int t = 0; t < BUFFER_TARGETS; t++)
+            buffers[t] = UNKNOWN;
+        for (int i = 0; i < MAX_BUFFER_RANGES; i++)
+            uniformRanges[i].buffer = UNKNOWN;
+        for (int c = 0; c < CAPABILITIES; c++)
+            capabilities[c] = UNKNOWN_FLAG;
+        blendSource = blendDestination = UNKNOWN;
+        depthFunction = UNKNOWN;
+        depthWrite = UNKNOWN_FLAG;
+        rasterMode = UNKNOWN;
+    }
+
+    void resetStats()
+    {
+        memset(&counters, 0, sizeof(counters));
+    }
+
+    const Stats& stats() const { return counters; }
+
+    void useProgram(GLuint id)
+    {
+        if (!changed(STATE_PROGRAM, program, id))
+            return;
+        glUseProgram(id);
+    }
+
+    void bindVertexArray(GLuint id)
+    {
+        if (!changed(STATE_VERTEX_ARRAY, vertexArray, id))
+            return;
+        glBindVertexArray(id);
+        // the element array binding belongs to the VAO
+        buffers[bufferIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+    }
+
+    // unit is 0, 1, ... not GL_TEXTURE0 + n
+    void bindTexture(GLuint unit, GLenum target, GLuint id)
+    {
+        int t = textureIndex(target);
+        if (unit >= (GLuint)MAX_TEXTURE_UNITS || t < 0)
+        {
+            activeTexture(unit);
+            issue(STATE_TEXTURE);
+            glBindTexture(target, id);
+            return;
+        }
+        if (!changed(STATE_TEXTURE, textures[unit][t], id))
+            return;
+        activeTexture(unit);
+        glBindTexture(target, id);
+    }
+
+    // for calls that act on the active unit, glTexParameter and glTexImage2D
+    void activeTexture(GLuint unit)
+    {
+        if (!changed(STATE_ACTIVE_TEXTURE, activeUnit, unit))
+            return;
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    void bindBuffer(GLenum target, GLuint id)
+    {
+        int t = bufferIndex(target);
+        if (t < 0)
+        {
+            issue(STATE_BUFFER);
+            glBindBuffer(target, id);
+            return;
+        }
+        if (!changed(STATE_BUFFER, buffers[t], id))
+            return;
+        glBindBuffer(target, id);
+    }
+
+    // indexed uniform buffer bindings; also binds the generic GL_UNIFORM_BUFFER point
+    void bindBufferRange(GLenum target, GLuint index, GLuint id, GLintptr offset, GLsizeiptr size)
+    {
+        if (target == GL_UNIFORM_BUFFER && index < (GLuint)MAX_BUFFER_RANGES)
+        {
+            BufferRange &range = uniformRanges[index];
+            if (range.buffer == id && range.offset == offset && range.size == size)
+            {
+                counters.elided[STATE_BUFFER_RANGE]++;
+                return;
+            }
+            range.buffer = id;
+            range.offset = offset;
+            range.size = size;
+        }
+        issue(STATE_BUFFER_RANGE);
+        glBindBufferRange(target, index, id, offset, size);
+        int t = bufferIndex(target);
+        if (t >= 0)
+            buffers[t] = id;
+    }
+
+    void enable(GLenum capability) { setCapability(capability, true); }
+    void disable(GLenum capability) { setCapability(capability, false); }
+
+    void blendFunc(GLenum source, GLenum destination)
+    {
+        if (blendSource == source && blendDestination == destination)
+        {
+            counters.elided[STATE_BLEND_FUNC]++;
+            return;
+        }
+        issue(STATE_BLEND_FUNC);
+        blendSource = source;
+        blendDestination = destination;
+        glBlendFunc(source, destination);
+    }
+
+    void depthFunc(GLenum function)
+    {
+        if (!changed(STATE_DEPTH_FUNC, depthFunction, function))
+            return;
+        glDepthFunc(function);
+    }
+
+    void depthMask(bool write)
+    {
+        int value = write ? 1 : 0;
+        if (depthWrite == value)
+        {
+            counters.elided[STATE_DEPTH_MASK]++;
+            return;
+        }
+        issue(STATE_DEPTH_MASK);
+        depthWrite = value;
+        glDepthMask(write ? GL_TRUE : GL_FALSE);
+    }
+
+    // core profile only accepts GL_FRONT_AND_BACK, so one mode is enough
+    void polygonMode(GLenum mode)
+    {
+        if (!changed(STATE_POLYGON_MODE, rasterMode, mode))
+            return;
+        glPolygonMode(GL_FRONT_AND_BACK, mode);
+    }
+
+    // GL unbinds deleted objects from the current context, so must the cache;
+    // a program in use is the exception, it stays current until replaced
+    void deleteProgram(GLuint id)
+    {
+        glDeleteProgram(id);
+    }
+
+    void deleteVertexArray(GLuint id)
+    {
+        if (id && vertexArray == id)
+        {
+            vertexArray = 0;
+            buffers[bufferIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+        }
+        glDeleteVertexArrays(1, &id);
+    }
+
+    void deleteBuffer(GLuint id)
+    {
+        for (int t = 0; t < BUFFER_TARGETS; t++)
+            if (id && buffers[t] == id)
+                buffers[t] = 0;
+        for (int i = 0; i < MAX_BUFFER_RANGES; i++)
+            if (id && uniformRanges[i].buffer == id)
+                uniformRanges[i].buffer = UNKNOWN;
+        glDeleteBuffers(1, &id);
+    }
+
+    void deleteTexture(GLuint id)
+    {
+        for (int u = 0; u < MAX_TEXTURE_UNITS; u++)
+            for (int t = 0; t < TEXTURE_TARGETS; t++)
+                if (id && textures[u][t] == id)
+                    textures[u][t] = 0;
+        glDeleteTextures(1, &id);
+    }
+
+    GLuint currentProgram() const { return program == UNKNOWN ? 0 : program; }
+
+private:
+    static const GLuint UNKNOWN = 0xFFFFFFFFu;
+    static const int UNKNOWN_FLAG = -1;
+    static const int TEXTURE_TARGETS = 4;
+    static const int BUFFER_TARGETS = 7;
+    static const int CAPABILITIES = 5;
+
+    struct BufferRange
+    {
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr size;
+    };
+
+    GLuint program;
+    GLuint vertexArray;
+    GLuint activeUnit;
+    GLuint textures[MAX_TEXTURE_UNITS][TEXTURE_TARGETS];
+    GLuint buffers[BUFFER_TARGETS];
+    BufferRange uniformRanges[MAX_BUFFER_RANGES];
+    int capabilities[CAPABILITIES];
+    GLenum blendSource;
+    GLenum blendDestination;
+    GLenum depthFunction;
+    int depthWrite;
+    GLenum rasterMode;
+    Stats counters;
+
+    void issue(GLStateCall call) { counters.issued[call]++; }
+
+    // records the new value and says whether the driver has to hear about it
+    bool changed(GLStateCall call, GLuint &shadow, GLuint value)
+    {
+        if (shadow == value)
+        {
+            counters.elided[call]++;
+            return false;
+        }
+        counters.issued[call]++;
+        shadow = value;
+        return true;
+    }
+
+    void setCapability(GLenum capability, bool on)
+    {
+        int c = capabilityIndex(capability);
+        if (c >= 0)
+        {
+            if (capabilities[c] == (on ? 1 : 0))
+            {
+                counters.elided[STATE_CAPABILITY]++;
+                return;
+            }
+            capabilities[c] = on ? 1 : 0;
+        }
+        issue(STATE_CAPABILITY);
+        if (on)
+            glEnable(capability);
+        else
+            glDisable(capability);
+    }
+
+    static int textureIndex(GLenum target)
+    {
+        switch (target)
+        {
+            case GL_TEXTURE_2D: return 0;
+            case GL_TEXTURE_CUBE_MAP: return 1;
+            case GL_TEXTURE_2D_ARRAY: return 2;
+            case GL_TEXTURE_3D: return 3;
+            default: return -1;
+        }
+    }
+
+    static int bufferIndex(GLenum target)
+    {
+        switch (target)
+        {
+            case GL_ARRAY_BUFFER: return 0;
+            case GL_ELEMENT_ARRAY_BUFFER: return 1;
+            case GL_UNIFORM_BUFFER: return 2;
+            case GL_COPY_READ_BUFFER: return 3;
+            case GL_COPY_WRITE_BUFFER: return 4;
+            case GL_PIXEL_UNPACK_BUFFER: return 5;
+            case GL_DRAW_INDIRECT_BUFFER: return 6;
+            default: return -1;
+        }
+    }
+
+    static int capabilityIndex(GLenum capability)
+    {
+        switch (capability)
+        {
+            case GL_DEPTH_TEST: return 0;
+            case GL_BLEND: return 1;
+            case GL_CULL_FACE: return 2;
+            case GL_SCISSOR_TEST: return 3;
+            case GL_STENCIL_TEST: return 4;
+            default: return -1;
+        }
+    }
+};
+
+// the shadow of the one context this program renders with
+inline GLStateCache& glState()
+{
+    static GLStateCache cache;
+    return cache;
+}
+
+#endif
@@ -0,0 +1,33 @@
+//
+//  Hash.h
+//  MyOpenGLPro7
+//
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+const uint64_t FNV64_OFFSET = 14695981039346656037ull;
+
+// 64-bit FNV-1a; pass the previous result as seed to hash several pieces as one
+inline uint64_t fnv1a64(const void *data, size_t length, uint64_t seed = FNV64_OFFSET)
+{
+    const unsigned char *bytes = (const unsigned char*)data;
+    uint64_t h = seed;
+    for (size_t i = 0; i < length; i++)
+    {
+        h ^= bytes[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+inline uint64_t fnv1a64(const std::string &s, uint64_t seed = FNV64_OFFSET)
+{
+    return fnv1a64(s.c_str(), s.size(), seed);
+}
+
+#endif
@@ -0,0 +1,105 @@
+//
+//  IndirectDrawBuilder.h
+//  MyOpenGLPro7
+//
+
+#ifndef INDIRECT_DRAW_BUILDER_H
+#define INDIRECT_DRAW_BUILDER_H
+
+#include <glad/glad.h>
+
+#include <iostream>
+#include <vector>
+
+// the layout glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// where one mesh lives inside the shared buffers
+struct MeshRange
+{
+    GLuint firstIndex = 0;
+    GLuint indexCount = 0;
+    GLint baseVertex = 0;
+};
+
+// Packs meshes that share a vertex format into one vertex and one 16 bit
+// index array, so they can all live in a single VAO, and builds the
+// DrawElementsIndirectCommand records that draw them. Indices stay relative
+// to their own mesh and baseVertex moves them, so the pool can hold more than
+// 65536 vertices in total. Makes no GL calls: the owner uploads vertexData()
+// and indexData() once, and the command list can be checked on the CPU.
+class IndirectDrawBuilder
+{
+public:
+    // stride is the size of one packed vertex, e.g. VertexFormat::stride();
+    // without one the builder only builds command lists
+    explicit IndirectDrawBuilder(size_t stride = 0) : vertexStride(stride) {}
+
+    MeshRange addMesh(const void *vertices, size_t vertexCount, const GLushort *indices, size_t indexCount)
+    {
+        MeshRange range;
+        if (vertexStride == 0)
+        {
+            std::cout << "ERROR::INDIRECT_DRAW::NO_VERTEX_STRIDE" << std::endl;
+            return range;
+        }
+        range.firstIndex = (GLuint)packedIndices.size();
+        range.indexCount = (GLuint)indexCount;
+        range.baseVertex = (GLint)(packedVertices.size() / vertexStride);
+        const unsigned char *source = (const unsigned char*)vertices;
+        packedVertices.insert(packedVertices.end(), source, source + vertexCount * vertexStride);
+        packedIndices.insert(packedIndices.end(), indices, indices + indexCount);
+        return range;
+    }
+
+    const std::vector<unsigned char>& vertexData() const { return packedVertices; }
+    const std::vector<GLushort>& indexData() const { return packedIndices; }
+    size_t stride() const { return vertexStride; }
+
+    // start a new command list; the packed meshes stay
+    void clear()
+    {
+        drawCommands.clear();
+    }
+
+    // instanceCount instances of mesh whose per-instance data starts at baseInstance;
+    // a draw that continues the previous one's mesh and instances extends it instead
+    void add(const MeshRange &mesh, GLuint instanceCount, GLuint baseInstance)
+    {
+        if (!drawCommands.empty())
+        {
+            DrawElementsIndirectCommand &last = drawCommands.back();
+            if (last.firstIndex == mesh.firstIndex && last.count == mesh.indexCount && last.baseVertex == mesh.baseVertex
+                && last.baseInstance + last.instanceCount == baseInstance)
+            {
+                last.instanceCount += instanceCount;
+                return;
+            }
+        }
+        DrawElementsIndirectCommand command;
+        command.count = mesh.indexCount;
+        command.instanceCount = instanceCount;
+        command.firstIndex = mesh.firstIndex;
+        command.baseVertex = mesh.baseVertex;
+        command.baseInstance = baseInstance;
+        drawCommands.push_back(command);
+    }
+
+    const std::vector<DrawElementsIndirectCommand>& commands() const { return drawCommands; }
+    size_t commandCount() const { return drawCommands.size(); }
+
+private:
+    size_t vertexStride;
+    std::vector<unsigned char> packedVertices;
+    std::vector<GLushort> packedIndices;
+    std::vector<DrawElementsIndirectCommand> drawCommands;
+};
+
+#endif
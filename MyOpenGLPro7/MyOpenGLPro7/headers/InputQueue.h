@@ -0,0 +1,142 @@
+//
+//  InputQueue.h
+//  MyOpenGLPro7
+//
+
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+#include "InputRecording.h"
+#include "SpscQueue.h"
+
+#include <vector>
+
+struct InputEvent
+{
+    enum Type {
+        LOOK,
+        SCROLL,
+        KEY_DOWN,
+        KEY_UP,
+        PICK
+    };
+
+    Type type;
+    // mouse offsets for LOOK, the wheel offset in y for SCROLL
+    float x;
+    float y;
+    // the Camera_Movement for KEY_DOWN and KEY_UP
+    int move;
+};
+
+// Carries input from the GLFW callbacks on the main thread to the simulation
+// thread. Mouse motion and scrolling only add up on the producer side, however
+// many events the OS delivers, and go out as one event per flush(); key
+// presses and clicks are queued as they happen so none are lost between two
+// steps. The simulation drains the queue once per step into the InputState it
+// steps and records, so the camera turns at most once per step.
+class InputQueue
+{
+public:
+    // producer side, from the callbacks
+    void look(float xoffset, float yoffset)
+    {
+        pendingX += xoffset;
+        pendingY += yoffset;
+    }
+
+    void scroll(float yoffset) { pendingScroll += yoffset; }
+
+    void key(int move, bool down) { send(makeEvent(down ? InputEvent::KEY_DOWN : InputEvent::KEY_UP, 0.0f, 0.0f, move)); }
+
+    void pick() { send(makeEvent(InputEvent::PICK, 0.0f, 0.0f, 0)); }
+
+    // producer side, after glfwPollEvents(): sends the motion collected since the last flush
+    void flush()
+    {
+        // events the full ring refused go first, in their original order
+        size_t sent = 0;
+        while (sent < backlog.size() && events.push(backlog[sent]))
+            sent++;
+        backlog.erase(backlog.begin(), backlog.begin() + sent);
+
+        if (pendingX != 0.0f || pendingY != 0.0f)
+        {
+            send(makeEvent(InputEvent::LOOK, pendingX, pendingY, 0));
+            pendingX = pendingY = 0.0f;
+        }
+        if (pendingScroll != 0.0f)
+        {
+            send(makeEvent(InputEvent::SCROLL, 0.0f, pendingScroll, 0));
+            pendingScroll = 0.0f;
+        }
+    }
+
+    // consumer side: fills state with everything queued since the last drain, false if nothing arrived.
+    // A key pressed and released again before the drain still counts as held for this one step.
+    bool drain(InputState &state)
+    {
+        state.lookX = state.lookY = state.scroll = 0.0f;
+        state.picks = 0;
+        bool tapped[4] = { false, false, false, false };
+        bool any = false;
+        InputEvent event;
+        while (events.pop(event))
+        {
+            any = true;
+            switch (event.type)
+            {
+                case InputEvent::LOOK:
+                    state.lookX += event.x;
+                    state.lookY += event.y;
+                    break;
+                case InputEvent::SCROLL:
+                    state.scroll += event.y;
+                    break;
+                case InputEvent::KEY_DOWN:
+                    held[event.move] = tapped[event.move] = true;
+                    break;
+                case InputEvent::KEY_UP:
+                    held[event.move] = false;
+                    break;
+                case InputEvent::PICK:
+                    state.picks++;
+                    break;
+            }
+        }
+        for (int i = 0; i < 4; i++)
+            state.moves[i] = held[i] || tapped[i];
+        return any;
+    }
+
+private:
+    // a few events per frame once motion is coalesced
+    static const size_t CAPACITY = 256;
+
+    SpscQueue<InputEvent, CAPACITY> events;
+    // producer only
+    float pendingX = 0.0f;
+    float pendingY = 0.0f;
+    float pendingScroll = 0.0f;
+    std::vector<InputEvent> backlog;
+    // consumer only, indexed by Camera_Movement
+    bool held[4] = { false, false, false, false };
+
+    static InputEvent makeEvent(InputEvent::Type type, float x, float y, int move)
+    {
+        InputEvent event;
+        event.type = type;
+        event.x = x;
+        event.y = y;
+        event.move = move;
+        return event;
+    }
+
+    void send(const InputEvent &event)
+    {
+        if (!backlog.empty() || !events.push(event))
+            backlog.push_back(event);
+    }
+};
+
+#endif
@@ -0,0 +1,169 @@
+//
+//  InputRecording.h
+//  MyOpenGLPro7
+//
+
+#ifndef INPUT_RECORDING_H
+#define INPUT_RECORDING_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// The input one simulation step saw. Keys are held or not; mouse motion,
+// scrolling and clicks are what arrived since the previous step, so the
+// values stay small however long the session runs and a step applies them
+// in a single call.
+struct InputState
+{
+    // indexed by Camera_Movement
+    bool moves[4] = { false, false, false, false };
+    float lookX = 0.0f;
+    float lookY = 0.0f;
+    float scroll = 0.0f;
+    // left clicks during this step
+    unsigned int picks = 0;
+};
+
+// The input every simulation step saw, in order. Steps are fixed, so
+// feeding the same recording to the same build reproduces the session
+// exactly, with or without a window, as long as the camera uses the same
+// depth mode, which the header keeps. Stored as a small header and 17 bytes
+// per step, host byte order.
+class InputRecording
+{
+public:
+    void clear() { steps.clear(); }
+    // whether the recorded camera used reverse-Z; it changes what the simulation culls
+    void setReversedDepth(bool reversed) { depthReversed = reversed; }
+    bool reversedDepth() const { return depthReversed; }
+    void add(const InputState &input) { steps.push_back(input); }
+
+    size_t size() const { return steps.size(); }
+    const InputState& operator[](size_t step) const { return steps[step]; }
+
+    // stepRate goes into the header; a replay at a different rate would diverge
+    bool save(const std::string &path, uint32_t stepRate) const
+    {
+        FILE *file = fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            std::cout << "ERROR::INPUT_RECORDING::CANNOT_WRITE " << path << std::endl;
+            return false;
+        }
+        Header header;
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.stepRate = stepRate;
+        header.count = (uint32_t)steps.size();
+        header.flags = depthReversed ? FLAG_REVERSED_DEPTH : 0;
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+        for (size_t i = 0; ok && i < steps.size(); i++)
+        {
+            unsigned char record[RECORD_SIZE];
+            encode(steps[i], record);
+            ok = fwrite(record, RECORD_SIZE, 1, file) == 1;
+        }
+        ok = fclose(file) == 0 && ok;
+        if (!ok)
+            std::cout << "ERROR::INPUT_RECORDING::CANNOT_WRITE " << path << std::endl;
+        return ok;
+    }
+
+    bool load(const std::string &path, uint32_t stepRate)
+    {
+        steps.clear();
+        depthReversed = false;
+        FILE *file = fopen(path.c_str(), "rb");
+        if (!file)
+        {
+            std::cout << "ERROR::INPUT_RECORDING::CANNOT_READ " << path << std::endl;
+            return false;
+        }
+        Header header;
+        bool ok = fread(&header, sizeof(header), 1, file) == 1
+            && header.magic == MAGIC && header.version == VERSION && header.stepRate == stepRate;
+        // a corrupt count must not size the vector; the records have to be there
+        ok = ok && endsAfter(file, (uint64_t)header.count * RECORD_SIZE);
+        if (ok)
+        {
+            depthReversed = (header.flags & FLAG_REVERSED_DEPTH) != 0;
+            steps.resize(header.count);
+            for (size_t i = 0; ok && i < steps.size(); i++)
+            {
+                unsigned char record[RECORD_SIZE];
+                ok = fread(record, RECORD_SIZE, 1, file) == 1;
+                if (ok)
+                    decode(record, steps[i]);
+            }
+        }
+        fclose(file);
+        if (!ok)
+        {
+            std::cout << "ERROR::INPUT_RECORDING::INVALID " << path << std::endl;
+            steps.clear();
+        }
+        return ok;
+    }
+
+private:
+    static const uint32_t MAGIC = 0x52504e49; // "INPR"
+    // bump when the record layout or meaning changes; 2 stores per-step deltas and the depth mode
+    static const uint32_t VERSION = 2;
+    static const uint32_t FLAG_REVERSED_DEPTH = 1;
+    // move bits, look x/y, scroll, picks
+    static const size_t RECORD_SIZE = 1 + 3 * sizeof(float) + sizeof(uint32_t);
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t stepRate;
+        uint32_t count;
+        uint32_t flags;
+    };
+
+    std::vector<InputState> steps;
+    bool depthReversed = false;
+
+    // true when exactly bytes remain after the read position
+    static bool endsAfter(FILE *file, uint64_t bytes)
+    {
+        long start = ftell(file);
+        if (start < 0 || fseek(file, 0, SEEK_END) != 0)
+            return false;
+        long end = ftell(file);
+        return fseek(file, start, SEEK_SET) == 0 && end >= start && (uint64_t)(end - start) == bytes;
+    }
+
+    static void encode(const InputState &input, unsigned char *record)
+    {
+        unsigned char moves = 0;
+        for (int i = 0; i < 4; i++)
+            if (input.moves[i])
+                moves |= (unsigned char)(1 << i);
+        uint32_t picks = input.picks;
+        record[0] = moves;
+        memcpy(record + 1, &input.lookX, sizeof(float));
+        memcpy(record + 5, &input.lookY, sizeof(float));
+        memcpy(record + 9, &input.scroll, sizeof(float));
+        memcpy(record + 13, &picks, sizeof(uint32_t));
+    }
+
+    static void decode(const unsigned char *record, InputState &input)
+    {
+        for (int i = 0; i < 4; i++)
+            input.moves[i] = (record[0] >> i) & 1;
+        uint32_t picks;
+        memcpy(&input.lookX, record + 1, sizeof(float));
+        memcpy(&input.lookY, record + 5, sizeof(float));
+        memcpy(&input.scroll, record + 9, sizeof(float));
+        memcpy(&picks, record + 13, sizeof(uint32_t));
+        input.picks = picks;
+    }
+};
+
+#endif
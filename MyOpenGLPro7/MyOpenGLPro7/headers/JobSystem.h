@@ -0,0 +1,174 @@
+//
+//  JobSystem.h
+//  MyOpenGLPro7
+//
+
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A small work-stealing thread pool. parallelFor splits a range into chunks
+// and deals them out to one queue per thread; every thread works from the
+// back of its own queue and, once that is empty, steals from the front of the
+// others, so uneven chunks even out by themselves. The calling thread works
+// too and returns when the whole range is done.
+// parallelFor must only be called from the thread that owns the pool.
+class JobSystem
+{
+public:
+    typedef std::function<void(size_t begin, size_t end)> RangeJob;
+
+    // workers in addition to the calling thread; by default one per remaining core
+    explicit JobSystem(unsigned int workerCount = defaultWorkers()) : running(true), queued(0)
+    {
+        for (unsigned int i = 0; i <= workerCount; i++)
+            queues.push_back(std::unique_ptr<Queue>(new Queue()));
+        for (unsigned int i = 1; i <= workerCount; i++)
+            threads.push_back(std::thread(&JobSystem::run, this, (size_t)i));
+    }
+
+    ~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            running = false;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < threads.size(); i++)
+            threads[i].join();
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // threads that take part in parallelFor, the caller included
+    size_t threadCount() const { return queues.size(); }
+
+    // run job over [0, count) in chunks of about grain items
+    void parallelFor(size_t count, size_t grain, const RangeJob &job)
+    {
+        grain = std::max<size_t>(grain, 1);
+        if (count <= grain || threads.empty())
+        {
+            if (count)
+                job(0, count);
+            return;
+        }
+
+        size_t chunks = (count + grain - 1) / grain;
+        std::atomic<size_t> remaining(chunks);
+        // counted before they are visible, so a thief never sees the count go below zero
+        queued += chunks;
+        for (size_t c = 0; c < chunks; c++)
+        {
+            Task task = {&job, c * grain, std::min(count, (c + 1) * grain), &remaining};
+            Queue &queue = *queues[c % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(task);
+        }
+        {
+            // pairs with the predicate check in run(), so no wake-up is lost
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wake.notify_all();
+
+        Task task;
+        while (remaining.load(std::memory_order_acquire) != 0)
+        {
+            if (take(0, task))
+                execute(task);
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    static unsigned int defaultWorkers()
+    {
+        unsigned int cores = std::thread::hardware_concurrency();
+        return cores > 1 ? cores - 1 : 0;
+    }
+
+private:
+    struct Task
+    {
+        const RangeJob *job;
+        size_t begin;
+        size_t end;
+        std::atomic<size_t> *remaining;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue> > queues;
+    std::vector<std::thread> threads;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool running;
+    std::atomic<size_t> queued;
+
+    // own queue from the back (the chunk dealt last is still warm), others from the front
+    bool take(size_t self, Task &task)
+    {
+        if (queued.load(std::memory_order_relaxed) == 0)
+            return false;
+        for (size_t n = 0; n < queues.size(); n++)
+        {
+            size_t index = (self + n) % queues.size();
+            Queue &queue = *queues[index];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty())
+                continue;
+            if (n == 0)
+            {
+                task = queue.tasks.back();
+                queue.tasks.pop_back();
+            }
+            else
+            {
+                task = queue.tasks.front();
+                queue.tasks.pop_front();
+            }
+            queued--;
+            return true;
+        }
+        return false;
+    }
+
+    static void execute(const Task &task)
+    {
+        (*task.job)(task.begin, task.end);
+        task.remaining->fetch_sub(1, std::memory_order_release);
+    }
+
+    void run(size_t self)
+    {
+        Task task;
+        for (;;)
+        {
+            if (take(self, task))
+            {
+                execute(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this] { return !running || queued.load() != 0; });
+            if (!running)
+                return;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,163 @@
+//
+//  ProgramCache.h
+//  MyOpenGLPro7
+//
+
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+#include "GLExtensions.h"
+#include "Hash.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+// On-disk cache of linked program binaries. An entry is keyed by the final
+// shader sources and the driver's vendor/renderer/version strings, so a driver
+// update or an edited shader simply misses; entries the driver rejects are deleted.
+class ProgramCache
+{
+public:
+    explicit ProgramCache(const std::string &directory = "shadercache") : directory(directory)
+    {
+        mkdir(directory.c_str(), 0755);
+        GLint formats = 0;
+        if (glExt().hasProgramBinary())
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        enabled = formats > 0;
+
+        driver = glString(GL_VENDOR);
+        driver += '\n';
+        driver += glString(GL_RENDERER);
+        driver += '\n';
+        driver += glString(GL_VERSION);
+    }
+
+    // false when the driver exposes no binary formats; everything else is then a no-op
+    bool supported() const { return enabled; }
+
+    uint64_t key(const char *vertexCode, size_t vertexLength, const char *fragmentCode, size_t fragmentLength) const
+    {
+        uint64_t h = fnv1a64(driver.c_str(), driver.size() + 1);
+        h = fnv1a64(vertexCode, vertexLength, h);
+        h = fnv1a64("", 1, h);
+        return fnv1a64(fragmentCode, fragmentLength, h);
+    }
+
+    // returns a linked program or 0 on a miss
+    GLuint load(uint64_t key) const
+    {
+        if (!enabled)
+            return 0;
+        std::string path = entryPath(key);
+        FILE *file = fopen(path.c_str(), "rb");
+        if (!file)
+            return 0;
+
+        Header header;
+        std::vector<char> binary;
+        bool ok = fread(&header, sizeof(header), 1, file) == 1
+            && header.magic == MAGIC && header.version == VERSION && header.key == key;
+        if (ok)
+        {
+            binary.resize(header.length);
+            ok = header.length > 0 && fread(&binary[0], 1, binary.size(), file) == binary.size();
+        }
+        fclose(file);
+
+        GLuint program = 0;
+        if (ok)
+        {
+            program = glCreateProgram();
+            glExt().ProgramBinary(program, header.format, &binary[0], (GLsizei)binary.size());
+            GLint success = 0;
+            glGetProgramiv(program, GL_LINK_STATUS, &success);
+            if (!success)
+            {
+                glDeleteProgram(program);
+                program = 0;
+            }
+        }
+        // stale or corrupt, recompile and let store() write a fresh one
+        if (!program)
+            remove(path.c_str());
+        return program;
+    }
+
+    // set before glLinkProgram so the driver keeps a retrievable binary around
+    void prepare(GLuint program) const
+    {
+        if (enabled)
+            glExt().ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // write a successfully linked program
+    void store(uint64_t key, GLuint program) const
+    {
+        if (!enabled)
+            return;
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+        std::vector<char> binary(length);
+        Header header;
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.key = key;
+        GLsizei written = 0;
+        glExt().GetProgramBinary(program, length, &written, &header.format, &binary[0]);
+        if (written <= 0)
+            return;
+        header.length = (uint32_t)written;
+
+        // write aside and rename so a crash never leaves a half-written entry
+        std::string path = entryPath(key);
+        std::string temp = path + ".tmp";
+        FILE *file = fopen(temp.c_str(), "wb");
+        if (!file)
+            return;
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+            && fwrite(&binary[0], 1, written, file) == (size_t)written;
+        ok = fclose(file) == 0 && ok;
+        if (!ok || rename(temp.c_str(), path.c_str()) != 0)
+            remove(temp.c_str());
+    }
+
+private:
+    static const uint32_t MAGIC = 0x42504c47; // "GLPB"
+    // bump when the file layout changes
+    static const uint32_t VERSION = 1;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        GLenum format;
+        uint32_t length;
+    };
+
+    std::string directory;
+    std::string driver;
+    bool enabled = false;
+
+    std::string entryPath(uint64_t key) const
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+        return directory + "/" + name;
+    }
+
+    static std::string glString(GLenum name)
+    {
+        const GLubyte *s = glGetString(name);
+        return s ? std::string((const char*)s) : std::string();
+    }
+};
+
+#endif
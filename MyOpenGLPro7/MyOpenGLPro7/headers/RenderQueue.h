@@ -0,0 +1,375 @@
+//
+//  RenderQueue.h
+//  MyOpenGLPro7
+//
+
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+#include "../glm/glm/glm.hpp"
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+#include "IndirectDrawBuilder.h"
+#include "StreamBuffer.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Collects a frame's draws, sorts them by state and submits each run of
+// draws that share program, textures and mesh as one instanced draw. With
+// GL 4.3 all runs that also share the vertex array (different meshes packed
+// into one VAO by IndirectDrawBuilder) go out as one glMultiDrawElementsIndirect,
+// each command's baseInstance selecting its slice of the instance data;
+// without it every run is its own glDrawElementsInstancedBaseVertex. Up to
+// 256 meshes a group has one command per mesh; beyond that the mesh field
+// wraps, meshes interleave in the sort and one mesh may take several commands.
+// Every draw is a 64 bit key plus its model matrix:
+//   pass 3 | program 10 | texture set 10 | vertex array 9 | mesh 8 | depth 24
+// so a radix sort puts passes in order, groups by the most expensive state
+// first, and orders opaque draws front to back (transparent back to front).
+// The key only orders: groups and runs are cut by comparing the draws' real
+// program, textures and mesh. Past 1024 programs, 1024 texture sets, 512
+// vertex arrays or 256 meshes the fields wrap, so different states can end
+// up interleaved; every draw still gets its own state, it only merges less.
+// The model matrix reaches the shader as a per-instance mat4 at
+// MODEL_ATTRIB (the INSTANCED variant of vshader.vs); any other per-object
+// data has to travel the same way, since runs are merged.
+class RenderQueue
+{
+public:
+    enum Pass {
+        PASS_OPAQUE,
+        PASS_TRANSPARENT
+    };
+
+    struct Stats
+    {
+        unsigned int draws = 0;
+        unsigned int drawCalls = 0;
+        unsigned int indirectCommands = 0;
+        unsigned int programChanges = 0;
+        unsigned int textureChanges = 0;
+        unsigned int vertexArrayChanges = 0;
+    };
+
+    // first of the four vec4 attribute locations taken by the model matrix
+    static const GLuint MODEL_ATTRIB = 2;
+    static const int MAX_TEXTURES = 4;
+
+    RenderQueue() : instances(GL_ARRAY_BUFFER), commandStream(GL_DRAW_INDIRECT_BUFFER) {}
+
+    RenderQueue(const RenderQueue&) = delete;
+    RenderQueue& operator=(const RenderQueue&) = delete;
+
+    // an indexed mesh in vao, firstIndex indices into its element buffer and
+    // baseVertex vertices into its vertex buffer; the instance attributes are enabled on vao here
+    uint32_t addMesh(GLuint vao, GLsizei indexCount, GLenum indexType = GL_UNSIGNED_SHORT, GLuint firstIndex = 0, GLint baseVertex = 0)
+    {
+        Mesh mesh;
+        mesh.vao = vao;
+        mesh.vaoSlot = slotOf(vertexArrays, vao);
+        mesh.range.firstIndex = firstIndex;
+        mesh.range.indexCount = (GLuint)indexCount;
+        mesh.range.baseVertex = baseVertex;
+        mesh.indexType = indexType;
+        mesh.indexSize = indexType == GL_UNSIGNED_INT ? 4 : indexType == GL_UNSIGNED_SHORT ? 2 : 1;
+        meshes.push_back(mesh);
+
+        glState().bindVertexArray(vao);
+        for (GLuint column = 0; column < 4; column++)
+        {
+            glEnableVertexAttribArray(MODEL_ATTRIB + column);
+            // advance once per instance instead of once per vertex
+            glVertexAttribDivisor(MODEL_ATTRIB + column, 1);
+        }
+        return (uint32_t)(meshes.size() - 1);
+    }
+
+    // a mesh packed by IndirectDrawBuilder, whose buffers are attached to vao
+    uint32_t addMesh(GLuint vao, const MeshRange &range)
+    {
+        return addMesh(vao, (GLsizei)range.indexCount, GL_UNSIGNED_SHORT, range.firstIndex, range.baseVertex);
+    }
+
+    // 2D textures bound to units 0, 1, ... for the draws that use the set
+    uint32_t addTextureSet(const GLuint *textures, int count)
+    {
+        TextureSet set;
+        set.count = count < MAX_TEXTURES ? count : MAX_TEXTURES;
+        for (int i = 0; i < set.count; i++)
+            set.textures[i] = textures[i];
+        textureSets.push_back(set);
+        return (uint32_t)(textureSets.size() - 1);
+    }
+
+    // depth is the distance from the camera, only its order matters
+    void submit(Pass pass, GLuint program, uint32_t textureSet, uint32_t mesh, float depth, const glm::mat4 &model)
+    {
+        Draw draw;
+        draw.program = program;
+        draw.textureSet = textureSet;
+        draw.mesh = mesh;
+        draw.model = model;
+        uint64_t depthBits = quantizeDepth(depth);
+        if (pass == PASS_TRANSPARENT)
+            depthBits = DEPTH_MASK - depthBits;
+        draw.key = ((uint64_t)pass << 61)
+                 | ((uint64_t)(slotOf(programs, program) & 0x3FF) << 51)
+                 | ((uint64_t)(textureSet & 0x3FF) << 41)
+                 | ((uint64_t)(meshes[mesh].vaoSlot & 0x1FF) << 32)
+                 | ((uint64_t)(mesh & 0xFF) << 24)
+                 | depthBits;
+        draws.push_back(draw);
+    }
+
+    // sort, merge and draw everything submitted since the last flush
+    void flush()
+    {
+        frameStats = Stats();
+        frameStats.draws = (unsigned int)draws.size();
+        if (draws.empty())
+            return;
+        sortKeys();
+
+        // one allocation for all instance data of the flush, in sorted order
+        GLsizeiptr bytes = (GLsizeiptr)(draws.size() * sizeof(glm::mat4));
+        instances.reserve(bytes);
+        bool indirect = glExt().hasMultiDrawIndirect();
+        if (indirect)
+            commandStream.reserve((GLsizeiptr)(draws.size() * sizeof(DrawElementsIndirectCommand)));
+        StreamBuffer::Allocation range = instances.allocate(bytes, sizeof(glm::vec4));
+        if (!range.data)
+        {
+            draws.clear();
+            return;
+        }
+        glm::mat4 *models = (glm::mat4*)range.data;
+        for (size_t i = 0; i < order.size(); i++)
+            models[i] = draws[order[i].index].model;
+        instances.commit(range);
+
+        const Draw *previous = NULL;
+        for (size_t begin = 0; begin < order.size(); )
+        {
+            // a group shares pass, program, textures and vertex array; its runs differ in mesh
+            GLenum indexType = meshes[draws[order[begin].index].mesh].indexType;
+            size_t groupEnd = begin + 1;
+            while (groupEnd < order.size() && sameGroup(order[groupEnd], order[begin]))
+                groupEnd++;
+            const Draw &draw = draws[order[begin].index];
+            bind(draw, previous);
+            glState().bindBuffer(GL_ARRAY_BUFFER, instances.buffer());
+            if (indirect)
+                drawIndirect(begin, groupEnd, range.offset, indexType);
+            else
+                drawRuns(begin, groupEnd, range.offset);
+            previous = &draw;
+            begin = groupEnd;
+        }
+        draws.clear();
+    }
+
+    // fence this frame's instance data; call after the frame's draws
+    void endFrame()
+    {
+        instances.endFrame();
+        commandStream.endFrame();
+    }
+
+    // counts of the last flush
+    const Stats& stats() const { return frameStats; }
+
+    // must run while the context is still alive
+    void release()
+    {
+        instances.release();
+        commandStream.release();
+    }
+
+private:
+    static const uint64_t DEPTH_MASK = 0xFFFFFF;
+
+    struct Mesh
+    {
+        GLuint vao;
+        uint32_t vaoSlot;
+        MeshRange range;
+        GLenum indexType;
+        size_t indexSize;
+    };
+
+    struct TextureSet
+    {
+        GLuint textures[MAX_TEXTURES];
+        int count;
+    };
+
+    struct Draw
+    {
+        uint64_t key;
+        GLuint program;
+        uint32_t textureSet;
+        uint32_t mesh;
+        glm::mat4 model;
+    };
+
+    struct SortEntry
+    {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    std::vector<Mesh> meshes;
+    std::vector<TextureSet> textureSets;
+    std::vector<GLuint> programs;
+    std::vector<GLuint> vertexArrays;
+    std::vector<Draw> draws;
+    std::vector<SortEntry> order;
+    std::vector<SortEntry> scratch;
+    StreamBuffer instances;
+    StreamBuffer commandStream;
+    IndirectDrawBuilder commandList;
+    Stats frameStats;
+
+    // small dense ids for GL names, in order of first use
+    static uint32_t slotOf(std::vector<GLuint> &names, GLuint name)
+    {
+        for (size_t i = 0; i < names.size(); i++)
+            if (names[i] == name)
+                return (uint32_t)i;
+        names.push_back(name);
+        return (uint32_t)(names.size() - 1);
+    }
+
+    // non-negative floats order like their bit patterns; keep the top 24 bits
+    static uint64_t quantizeDepth(float depth)
+    {
+        if (!(depth > 0.0f))
+            return 0;
+        uint32_t bits;
+        memcpy(&bits, &depth, sizeof(bits));
+        return (bits >> 7) & DEPTH_MASK;
+    }
+
+    // LSD radix sort on bytes, skipping bytes all keys agree on
+    void sortKeys()
+    {
+        order.resize(draws.size());
+        scratch.resize(draws.size());
+        for (size_t i = 0; i < draws.size(); i++)
+        {
+            order[i].key = draws[i].key;
+            order[i].index = (uint32_t)i;
+        }
+        for (int shift = 0; shift < 64; shift += 8)
+        {
+            size_t counts[256] = {0};
+            for (size_t i = 0; i < order.size(); i++)
+                counts[(order[i].key >> shift) & 0xFF]++;
+            if (counts[(order[0].key >> shift) & 0xFF] == order.size())
+                continue;
+            size_t offsets[256];
+            size_t sum = 0;
+            for (int b = 0; b < 256; b++)
+            {
+                offsets[b] = sum;
+                sum += counts[b];
+            }
+            for (size_t i = 0; i < order.size(); i++)
+                scratch[offsets[(order[i].key >> shift) & 0xFF]++] = order[i];
+            order.swap(scratch);
+        }
+    }
+
+    // same pass, program, textures, vertex array and index type: one bind, one multi-draw
+    bool sameGroup(const SortEntry &a, const SortEntry &b) const
+    {
+        const Draw &first = draws[a.index];
+        const Draw &second = draws[b.index];
+        const Mesh &firstMesh = meshes[first.mesh];
+        const Mesh &secondMesh = meshes[second.mesh];
+        return (a.key >> 61) == (b.key >> 61) && first.program == second.program && first.textureSet == second.textureSet
+            && firstMesh.vao == secondMesh.vao && firstMesh.indexType == secondMesh.indexType;
+    }
+
+    // the end of the run of draws starting at begin, which share everything but depth
+    size_t runEnd(size_t begin, size_t end) const
+    {
+        size_t run = begin + 1;
+        while (run < end && draws[order[run].index].mesh == draws[order[begin].index].mesh)
+            run++;
+        return run;
+    }
+
+    // point the model matrix attributes at instance data starting at offset
+    static void pointInstances(GLintptr offset)
+    {
+        for (GLuint column = 0; column < 4; column++)
+            glVertexAttribPointer(MODEL_ATTRIB + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                                  (void*)(offset + sizeof(glm::vec4) * column));
+    }
+
+    // one command per run, baseInstance indexing into the flush's instance data
+    void drawIndirect(size_t begin, size_t end, GLintptr instanceOffset, GLenum indexType)
+    {
+        commandList.clear();
+        for (size_t run = begin; run < end; )
+        {
+            size_t next = runEnd(run, end);
+            commandList.add(meshes[draws[order[run].index].mesh].range, (GLuint)(next - run), (GLuint)run);
+            run = next;
+        }
+        GLsizeiptr bytes = (GLsizeiptr)(commandList.commandCount() * sizeof(DrawElementsIndirectCommand));
+        StreamBuffer::Allocation commands = commandStream.allocate(bytes, 4);
+        if (!commands.data)
+            return;
+        memcpy(commands.data, &commandList.commands()[0], (size_t)bytes);
+        commandStream.commit(commands);
+        pointInstances(instanceOffset);
+        glState().bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandStream.buffer());
+        glExt().MultiDrawElementsIndirect(GL_TRIANGLES, indexType, (void*)commands.offset, (GLsizei)commandList.commandCount(), 0);
+        frameStats.drawCalls++;
+        frameStats.indirectCommands += (unsigned int)commandList.commandCount();
+    }
+
+    // one draw per run, the instance attributes re-pointed at the run's slice
+    void drawRuns(size_t begin, size_t end, GLintptr instanceOffset)
+    {
+        for (size_t run = begin; run < end; )
+        {
+            size_t next = runEnd(run, end);
+            const Mesh &mesh = meshes[draws[order[run].index].mesh];
+            pointInstances(instanceOffset + (GLintptr)(run * sizeof(glm::mat4)));
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, (GLsizei)mesh.range.indexCount, mesh.indexType,
+                                              (void*)(mesh.range.firstIndex * mesh.indexSize),
+                                              (GLsizei)(next - run), mesh.range.baseVertex);
+            frameStats.drawCalls++;
+            run = next;
+        }
+    }
+
+    void bind(const Draw &draw, const Draw *previous)
+    {
+        if (!previous || previous->program != draw.program)
+        {
+            glState().useProgram(draw.program);
+            frameStats.programChanges++;
+        }
+        if (!previous || previous->textureSet != draw.textureSet)
+        {
+            const TextureSet &set = textureSets[draw.textureSet];
+            for (int unit = 0; unit < set.count; unit++)
+                glState().bindTexture((GLuint)unit, GL_TEXTURE_2D, set.textures[unit]);
+            frameStats.textureChanges++;
+        }
+        if (!previous || meshes[previous->mesh].vao != meshes[draw.mesh].vao)
+        {
+            glState().bindVertexArray(meshes[draw.mesh].vao);
+            frameStats.vertexArrayChanges++;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,445 @@
+//
+//  SceneBVH.h
+//  MyOpenGLPro7
+//
+
+#ifndef SCENE_BVH_H
+#define SCENE_BVH_H
+
+#include <glad/glad.h>
+#include "../glm/glm/glm.hpp"
+#include "../glm/glm/gtx/intersect.hpp"
+#include "Frustum.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Triangles of one mesh in its own space, for exact ray hits at the leaves.
+struct BVHMesh
+{
+    std::vector<glm::vec3> positions;
+    std::vector<GLushort> indices;
+    glm::vec3 minimum = glm::vec3(FLT_MAX);
+    glm::vec3 maximum = glm::vec3(-FLT_MAX);
+
+    // positions are the first three floats of every stride-float vertex
+    BVHMesh(const float *vertices, size_t vertexCount, size_t stride, const std::vector<GLushort> &triangleIndices)
+        : indices(triangleIndices)
+    {
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            glm::vec3 p(vertices[v * stride], vertices[v * stride + 1], vertices[v * stride + 2]);
+            positions.push_back(p);
+            minimum = glm::min(minimum, p);
+            maximum = glm::max(maximum, p);
+        }
+    }
+};
+
+// A bounding volume hierarchy over the world-space boxes of scene objects.
+// build() splits top-down with the surface area heuristic over binned
+// centroids; refit() only recomputes the boxes bottom-up, which is all moving
+// objects need as long as they do not drift far from where they were built.
+// Queries: objects overlapping a frustum, the closest ray hit (against the
+// object's triangles when it has a mesh, glm::intersectRayTriangle at the
+// leaves) and the object whose box is nearest to a point.
+class SceneBVH
+{
+public:
+    struct RayHit
+    {
+        int object = -1;
+        int triangle = -1;
+        float distance = FLT_MAX;
+        // of the hit point on the triangle, relative to its second and third corner
+        glm::vec2 barycentric;
+    };
+
+    // returns the object's index, which all other calls use
+    uint32_t add(const glm::vec3 &minimum, const glm::vec3 &maximum)
+    {
+        Object object;
+        object.minimum = minimum;
+        object.maximum = maximum;
+        objects.push_back(object);
+        return (uint32_t)(objects.size() - 1);
+    }
+
+    size_t size() const { return objects.size(); }
+
+    // a moved object; call refit() (or build()) afterwards
+    void setBounds(uint32_t object, const glm::vec3 &minimum, const glm::vec3 &maximum)
+    {
+        objects[object].minimum = minimum;
+        objects[object].maximum = maximum;
+    }
+
+    // hit-test the object's triangles instead of its box; model places the mesh in the world
+    void setMesh(uint32_t object, const BVHMesh *mesh, const glm::mat4 &model)
+    {
+        objects[object].mesh = mesh;
+        objects[object].worldToLocal = glm::inverse(model);
+    }
+
+    void build()
+    {
+        nodes.clear();
+        order.resize(objects.size());
+        for (size_t i = 0; i < order.size(); i++)
+            order[i] = (uint32_t)i;
+        if (objects.empty())
+            return;
+        nodes.reserve(objects.size() * 2);
+        Node root;
+        root.first = 0;
+        root.count = (uint32_t)objects.size();
+        nodes.push_back(root);
+        subdivide(0, 0);
+    }
+
+    // children always come after their parent, so one backwards pass is bottom-up
+    void refit()
+    {
+        for (size_t n = nodes.size(); n-- > 0; )
+        {
+            Node &node = nodes[n];
+            if (node.count > 0)
+            {
+                fitLeaf(node);
+            }
+            else
+            {
+                const Node &left = nodes[node.first];
+                const Node &right = nodes[node.first + 1];
+                node.minimum = glm::min(left.minimum, right.minimum);
+                node.maximum = glm::max(left.maximum, right.maximum);
+            }
+        }
+    }
+
+    // every object whose box is at least partly inside
+    void queryFrustum(const Frustum &frustum, std::vector<uint32_t> &visible) const
+    {
+        visible.clear();
+        if (nodes.empty())
+            return;
+        uint32_t stack[STACK_SIZE];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+            const Node &node = nodes[stack[--top]];
+            if (!frustum.intersectsBox(node.minimum, node.maximum))
+                continue;
+            if (node.count > 0)
+            {
+                for (uint32_t i = node.first; i < node.first + node.count; i++)
+                    if (frustum.intersectsBox(objects[order[i]].minimum, objects[order[i]].maximum))
+                        visible.push_back(order[i]);
+            }
+            else
+            {
+                stack[top++] = node.first;
+                stack[top++] = node.first + 1;
+            }
+        }
+    }
+
+    // closest hit along origin + t * direction for t in [0, maxDistance]
+    bool raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, RayHit &hit) const
+    {
+        hit = RayHit();
+        hit.distance = maxDistance;
+        if (nodes.empty())
+            return false;
+        glm::vec3 inverseDirection = 1.0f / direction;
+        uint32_t stack[STACK_SIZE];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+            const Node &node = nodes[stack[--top]];
+            if (slab(origin, inverseDirection, node.minimum, node.maximum) >= hit.distance)
+                continue;
+            if (node.count > 0)
+            {
+                for (uint32_t i = node.first; i < node.first + node.count; i++)
+                    intersectObject(order[i], origin, direction, inverseDirection, hit);
+                continue;
+            }
+            // visit the nearer child first so the further one is more often skipped
+            uint32_t nearChild = node.first, farChild = node.first + 1;
+            if (slab(origin, inverseDirection, nodes[nearChild].minimum, nodes[nearChild].maximum) >
+                slab(origin, inverseDirection, nodes[farChild].minimum, nodes[farChild].maximum))
+                std::swap(nearChild, farChild);
+            stack[top++] = farChild;
+            stack[top++] = nearChild;
+        }
+        return hit.object >= 0;
+    }
+
+    // the object whose box is closest to point (0 when inside), -1 if none within maxDistance
+    int nearest(const glm::vec3 &point, float maxDistance, float &distance) const
+    {
+        int best = -1;
+        float bestSquared = maxDistance * maxDistance;
+        if (nodes.empty())
+            return best;
+        uint32_t stack[STACK_SIZE];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+            const Node &node = nodes[stack[--top]];
+            if (distanceSquared(point, node.minimum, node.maximum) > bestSquared)
+                continue;
+            if (node.count > 0)
+            {
+                for (uint32_t i = node.first; i < node.first + node.count; i++)
+                {
+                    const Object &object = objects[order[i]];
+                    float d = distanceSquared(point, object.minimum, object.maximum);
+                    if (d <= bestSquared)
+                    {
+                        bestSquared = d;
+                        best = (int)order[i];
+                    }
+                }
+                continue;
+            }
+            uint32_t nearChild = node.first, farChild = node.first + 1;
+            if (distanceSquared(point, nodes[nearChild].minimum, nodes[nearChild].maximum) >
+                distanceSquared(point, nodes[farChild].minimum, nodes[farChild].maximum))
+                std::swap(nearChild, farChild);
+            stack[top++] = farChild;
+            stack[top++] = nearChild;
+        }
+        distance = std::sqrt(bestSquared);
+        return best;
+    }
+
+    size_t nodeCount() const { return nodes.size(); }
+
+private:
+    // objects per leaf the builder aims for, and the most it accepts when splitting does not pay
+    static const uint32_t LEAF_SIZE = 2;
+    static const uint32_t MAX_LEAF_SIZE = 8;
+    static const int BINS = 12;
+    // keeps the traversal stacks below bounded
+    static const int MAX_DEPTH = 48;
+    static const int STACK_SIZE = 64;
+
+    struct Object
+    {
+        glm::vec3 minimum;
+        glm::vec3 maximum;
+        const BVHMesh *mesh = NULL;
+        glm::mat4 worldToLocal;
+    };
+
+    // a leaf when count > 0 (objects order[first, first + count)), else children at first and first + 1
+    struct Node
+    {
+        glm::vec3 minimum;
+        glm::vec3 maximum;
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    struct Bin
+    {
+        glm::vec3 minimum = glm::vec3(FLT_MAX);
+        glm::vec3 maximum = glm::vec3(-FLT_MAX);
+        uint32_t count = 0;
+    };
+
+    std::vector<Object> objects;
+    std::vector<uint32_t> order;
+    std::vector<Node> nodes;
+
+    static float area(const glm::vec3 &minimum, const glm::vec3 &maximum)
+    {
+        glm::vec3 e = glm::max(maximum - minimum, glm::vec3(0.0f));
+        return e.x * e.y + e.y * e.z + e.z * e.x;
+    }
+
+    glm::vec3 centroid(uint32_t object) const
+    {
+        return (objects[object].minimum + objects[object].maximum) * 0.5f;
+    }
+
+    void fitLeaf(Node &node) const
+    {
+        node.minimum = glm::vec3(FLT_MAX);
+        node.maximum = glm::vec3(-FLT_MAX);
+        for (uint32_t i = node.first; i < node.first + node.count; i++)
+        {
+            node.minimum = glm::min(node.minimum, objects[order[i]].minimum);
+            node.maximum = glm::max(node.maximum, objects[order[i]].maximum);
+        }
+    }
+
+    void subdivide(uint32_t index, int depth)
+    {
+        Node &node = nodes[index];
+        fitLeaf(node);
+        if (node.count <= LEAF_SIZE || depth >= MAX_DEPTH)
+            return;
+
+        glm::vec3 centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+        for (uint32_t i = node.first; i < node.first + node.count; i++)
+        {
+            centroidMin = glm::min(centroidMin, centroid(order[i]));
+            centroidMax = glm::max(centroidMax, centroid(order[i]));
+        }
+
+        // cheapest split plane over all three axes, binned
+        int bestAxis = -1;
+        int bestSplit = 0;
+        float bestCost = FLT_MAX;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float extent = centroidMax[axis] - centroidMin[axis];
+            if (extent <= 0.0f)
+                continue;
+            Bin bins[BINS];
+            float scale = BINS / extent;
+            for (uint32_t i = node.first; i < node.first + node.count; i++)
+            {
+                const Object &object = objects[order[i]];
+                int b = std::min(BINS - 1, (int)((centroid(order[i])[axis] - centroidMin[axis]) * scale));
+                bins[b].count++;
+                bins[b].minimum = glm::min(bins[b].minimum, object.minimum);
+                bins[b].maximum = glm::max(bins[b].maximum, object.maximum);
+            }
+            // sweep from both ends to get the area and count left and right of every plane
+            float leftArea[BINS - 1], rightArea[BINS - 1];
+            uint32_t leftCount[BINS - 1], rightCount[BINS - 1];
+            Bin left, right;
+            for (int b = 0; b < BINS - 1; b++)
+            {
+                left.count += bins[b].count;
+                left.minimum = glm::min(left.minimum, bins[b].minimum);
+                left.maximum = glm::max(left.maximum, bins[b].maximum);
+                leftCount[b] = left.count;
+                leftArea[b] = area(left.minimum, left.maximum);
+                right.count += bins[BINS - 1 - b].count;
+                right.minimum = glm::min(right.minimum, bins[BINS - 1 - b].minimum);
+                right.maximum = glm::max(right.maximum, bins[BINS - 1 - b].maximum);
+                rightCount[BINS - 2 - b] = right.count;
+                rightArea[BINS - 2 - b] = area(right.minimum, right.maximum);
+            }
+            for (int b = 0; b < BINS - 1; b++)
+            {
+                if (leftCount[b] == 0 || rightCount[b] == 0)
+                    continue;
+                float cost = leftCount[b] * leftArea[b] + rightCount[b] * rightArea[b];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b;
+                }
+            }
+        }
+
+        float leafCost = node.count * area(node.minimum, node.maximum);
+        if (bestAxis < 0 || (bestCost >= leafCost && node.count <= MAX_LEAF_SIZE))
+        {
+            if (bestAxis >= 0 || node.count <= MAX_LEAF_SIZE)
+                return;
+            // every centroid in one spot: no plane separates them, split the list in half
+            uint32_t half = node.count / 2;
+            split(index, node.first + half, depth);
+            return;
+        }
+
+        // partition order[] around the chosen plane
+        float scale = BINS / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+        uint32_t i = node.first, j = node.first + node.count;
+        while (i < j)
+        {
+            int b = std::min(BINS - 1, (int)((centroid(order[i])[bestAxis] - centroidMin[bestAxis]) * scale));
+            if (b <= bestSplit)
+                i++;
+            else
+                std::swap(order[i], order[--j]);
+        }
+        split(index, i, depth);
+    }
+
+    // turn a node into two children holding [first, middle) and [middle, first + count)
+    void split(uint32_t index, uint32_t middle, int depth)
+    {
+        Node left, right;
+        left.first = nodes[index].first;
+        left.count = middle - left.first;
+        right.first = middle;
+        right.count = nodes[index].first + nodes[index].count - middle;
+        uint32_t leftIndex = (uint32_t)nodes.size();
+        nodes.push_back(left);
+        nodes.push_back(right);
+        // push_back may have moved the nodes
+        nodes[index].first = leftIndex;
+        nodes[index].count = 0;
+        subdivide(leftIndex, depth + 1);
+        subdivide(leftIndex + 1, depth + 1);
+    }
+
+    // entry distance of the ray into the box, FLT_MAX on a miss
+    static float slab(const glm::vec3 &origin, const glm::vec3 &inverseDirection, const glm::vec3 &minimum, const glm::vec3 &maximum)
+    {
+        glm::vec3 t0 = (minimum - origin) * inverseDirection;
+        glm::vec3 t1 = (maximum - origin) * inverseDirection;
+        glm::vec3 nearT = glm::min(t0, t1);
+        glm::vec3 farT = glm::max(t0, t1);
+        float enter = std::max(std::max(nearT.x, nearT.y), std::max(nearT.z, 0.0f));
+        float exit = std::min(std::min(farT.x, farT.y), farT.z);
+        return enter <= exit ? enter : FLT_MAX;
+    }
+
+    static float distanceSquared(const glm::vec3 &point, const glm::vec3 &minimum, const glm::vec3 &maximum)
+    {
+        glm::vec3 d = glm::max(glm::max(minimum - point, point - maximum), glm::vec3(0.0f));
+        return glm::dot(d, d);
+    }
+
+    void intersectObject(uint32_t index, const glm::vec3 &origin, const glm::vec3 &direction, const glm::vec3 &inverseDirection, RayHit &hit) const
+    {
+        const Object &object = objects[index];
+        float enter = slab(origin, inverseDirection, object.minimum, object.maximum);
+        if (enter >= hit.distance)
+            return;
+        if (!object.mesh)
+        {
+            hit.object = (int)index;
+            hit.triangle = -1;
+            hit.distance = enter;
+            return;
+        }
+        // the local direction is left unnormalised, so t stays a world-space distance
+        glm::vec3 localOrigin = glm::vec3(object.worldToLocal * glm::vec4(origin, 1.0f));
+        glm::vec3 localDirection = glm::vec3(object.worldToLocal * glm::vec4(direction, 0.0f));
+        const BVHMesh &mesh = *object.mesh;
+        for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3)
+        {
+            // z of the result is the distance along the ray, x and y are barycentric
+            glm::vec3 result;
+            if (!glm::intersectRayTriangle(localOrigin, localDirection, mesh.positions[mesh.indices[t]],
+                                           mesh.positions[mesh.indices[t + 1]], mesh.positions[mesh.indices[t + 2]], result))
+                continue;
+            if (result.z < hit.distance)
+            {
+                hit.object = (int)index;
+                hit.triangle = (int)(t / 3);
+                hit.distance = result.z;
+                hit.barycentric = glm::vec2(result.x, result.y);
+            }
+        }
+    }
+};
+
+#endif
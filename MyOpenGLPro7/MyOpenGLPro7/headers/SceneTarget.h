@@ -0,0 +1,96 @@
+//
+//  SceneTarget.h
+//  MyOpenGLPro7
+//
+
+#ifndef SCENE_TARGET_H
+#define SCENE_TARGET_H
+
+#include <glad/glad.h>
+
+#include <iostream>
+
+// An offscreen framebuffer with an RGBA8 colour and a 32 bit float depth
+// buffer, blitted to the window once the frame is drawn. The window's own
+// depth buffer is usually 24 bit fixed point, where reverse-Z only gets rid
+// of the far plane; its precision gain needs float depth.
+class SceneTarget
+{
+public:
+    SceneTarget() {}
+
+    SceneTarget(const SceneTarget&) = delete;
+    SceneTarget& operator=(const SceneTarget&) = delete;
+
+    // (re)allocate for a width x height framebuffer, nothing to do if the size is unchanged;
+    // false while minimised or if the driver cannot render to this combination
+    bool resize(int newWidth, int newHeight)
+    {
+        if (newWidth <= 0 || newHeight <= 0)
+            return false;
+        if (framebuffer && newWidth == width && newHeight == height)
+            return true;
+        if (!framebuffer)
+        {
+            glGenFramebuffers(1, &framebuffer);
+            glGenRenderbuffers(1, &color);
+            glGenRenderbuffers(1, &depth);
+        }
+        width = newWidth;
+        height = newHeight;
+        glBindRenderbuffer(GL_RENDERBUFFER, color);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32F, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+        bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (!complete)
+        {
+            std::cout << "ERROR::SCENE_TARGET::INCOMPLETE " << width << "x" << height << std::endl;
+            release();
+        }
+        return complete;
+    }
+
+    // draw into the target from here on
+    void bind() const
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    }
+
+    // copy the colour to the window and draw there again; call before the swap
+    void present() const
+    {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // must run while the context is still alive
+    void release()
+    {
+        if (framebuffer)
+        {
+            glDeleteFramebuffers(1, &framebuffer);
+            glDeleteRenderbuffers(1, &color);
+            glDeleteRenderbuffers(1, &depth);
+        }
+        framebuffer = color = depth = 0;
+        width = height = 0;
+    }
+
+private:
+    GLuint framebuffer = 0;
+    GLuint color = 0;
+    GLuint depth = 0;
+    int width = 0;
+    int height = 0;
+};
+
+#endif
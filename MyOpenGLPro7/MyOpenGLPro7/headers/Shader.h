@@ -11,21 +11,41 @@
 
 #include <glad/glad.h> // include glad to get all the required OpenGL headers
 
+#include <cassert>
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <vector>
+#include <utility>
 #include <iostream>
+#include <chrono>
 #include "../glm/glm/glm.hpp"
 #include "../glm/glm/gtc/type_ptr.hpp"
+#include "UniformTable.h"
+#include "ProgramCache.h"
+#include "ShaderSource.h"
+
+// A typed handle to a uniform, resolved once by name after linking.
+// Setting through a handle does no string hashing and no driver query; it
+// indexes a per-shader slot, so the handle stays valid when a reload relinks.
+template <typename T>
+struct Uniform
+{
+    int slot = -1;
+};
 
 class Shader
 {
+    friend class ShaderCompiler;
+    friend class ShaderHandle;
+    friend class ShaderReloader;
 public:
     // the program ID
     unsigned int ID;
     
-    // constructor reads and builds the shader
-    Shader(const GLchar* vertexPath, const GLchar* fragmentPath);
+    // constructor reads and builds the shader,
+    // loading the linked binary from cache instead when one is given and valid
+    Shader(const GLchar* vertexPath, const GLchar* fragmentPath, const ProgramCache* cache = NULL);
+    // set when a source file could not be loaded; ID is 0 in that case
+    const ShaderSourceError& loadError() const { return sourceError; }
     // use/activate the shader
     void use();
     // utility uniform functions
@@ -34,8 +54,93 @@ public:
     void setFloat(const std::string &name, float value) const;
     void setGlmValueMat4(const std::string &name, float value[]) const;
     void setVec2(const std::string &name, float value1, float value2) const;
+    
+    // resolve a typed handle; it sets nothing (location -1)
+    // while the uniform is not active or its GLSL type does not match T
+    template <typename T>
+    Uniform<T> getUniform(const std::string &name);
+    // typed uniform functions for the render loop
+    void set(Uniform<bool> uniform, bool value) const;
+    void set(Uniform<int> uniform, int value) const;
+    void set(Uniform<float> uniform, float value) const;
+    void set(Uniform<glm::vec2> uniform, const glm::vec2 &value) const;
+    void set(Uniform<glm::mat4> uniform, const glm::mat4 &value) const;
+    
+    // point the named uniform block at a uniform buffer binding point
+    // (remembered, and re-applied when the program is replaced)
+    void bindUniformBlock(const std::string &blockName, GLuint binding);
+    
+    // every active uniform reflected after linking
+    const UniformTable& uniforms() const { return uniformTable; }
+    
+private:
+    UniformTable uniformTable;
+    ShaderSourceError sourceError;
+    
+    // one entry per handle given out by getUniform
+    struct UniformSlot
+    {
+        std::string name;
+        bool (*matches)(GLenum glType);
+    };
+    std::vector<UniformSlot> slots;
+    std::vector<GLint> slotLocations;
+    std::vector<std::pair<std::string, GLuint> > blockBindings;
+    
+    // stage objects of a program whose compile and link are queued but not checked yet
+    struct Pending
+    {
+        GLuint vertex = 0;
+        GLuint fragment = 0;
+    };
+    
+    // an empty program, filled in by ShaderCompiler
+    Shader();
+    bool checkSources(const ShaderSource &vertexSource, const ShaderSource &fragmentSource);
+    bool loadCached(const ShaderSource &vertexSource, const ShaderSource &fragmentSource, const ProgramCache* cache, uint64_t &cacheKey);
+    Pending submit(const ShaderSource &vertexSource, const ShaderSource &fragmentSource, const ProgramCache* cache);
+    // the only place that waits on the driver: checks the link, prints logs, reflects uniforms
+    bool finish(Pending pending, const ProgramCache* cache, uint64_t cacheKey);
+    static void reportBuild(bool cacheHit, const std::string &name, std::chrono::steady_clock::time_point start);
+    // query all active uniforms once so the setters never call glGetUniformLocation
+    void reflectUniforms();
+    GLint location(const std::string &name) const;
+    // a handle is only good for the Shader that gave it out; one from another
+    // Shader can point past this one's slots, which sets nothing
+    GLint location(int slot) const
+    {
+        assert(slot < (int)slotLocations.size() && "Uniform handle from another Shader");
+        return slot >= 0 && slot < (int)slotLocations.size() ? slotLocations[slot] : -1;
+    }
+    GLint resolveSlot(const UniformSlot &slot) const;
+    // take over a freshly linked program, carrying uniform values and block bindings across
+    void swapProgram(Shader &fresh);
+    template <typename T>
+    static bool matches(GLenum glType) { return typeMatches(glType, (const Uniform<T>*)NULL); }
+    static bool typeMatches(GLenum glType, const Uniform<bool>*);
+    static bool typeMatches(GLenum glType, const Uniform<int>*);
+    static bool typeMatches(GLenum glType, const Uniform<float>*);
+    static bool typeMatches(GLenum glType, const Uniform<glm::vec2>*);
+    static bool typeMatches(GLenum glType, const Uniform<glm::mat4>*);
 };
 
+template <typename T>
+Uniform<T> Shader::getUniform(const std::string &name)
+{
+    Uniform<T> uniform;
+    for (size_t i = 0; i < slots.size(); i++)
+        if (slots[i].name == name && slots[i].matches == &matches<T>)
+            uniform.slot = (int)i;
+    if (uniform.slot < 0)
+    {
+        UniformSlot slot = {name, &matches<T>};
+        uniform.slot = (int)slots.size();
+        slots.push_back(slot);
+        slotLocations.push_back(resolveSlot(slot));
+    }
+    return uniform;
+}
+
 
 
 #endif /* Shader_h */
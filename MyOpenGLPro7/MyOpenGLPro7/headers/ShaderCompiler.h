@@ -0,0 +1,169 @@
+//
+//  ShaderCompiler.h
+//  MyOpenGLPro7
+//
+
+#ifndef SHADER_COMPILER_H
+#define SHADER_COMPILER_H
+
+#include <glad/glad.h>
+#include "Shader.h"
+#include "ProgramCache.h"
+#include "ShaderSource.h"
+#include "ShaderPreprocessor.h"
+#include "GLExtensions.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A program whose compile and link have been queued. get() is the only call
+// that may block, so other loading work can run between submit() and get().
+class ShaderHandle
+{
+public:
+    // true once get() will not stall; without KHR_parallel_shader_compile
+    // there is no way to ask the driver, so this is always true
+    bool ready() const
+    {
+        if (!state || state->finished)
+            return true;
+        if (!glExt().hasParallelShaderCompile())
+            return true;
+        GLint done = GL_FALSE;
+        glGetProgramiv(state->shader.ID, GL_COMPLETION_STATUS_KHR, &done);
+        return done == GL_TRUE;
+    }
+
+    // check the link status (blocking if still compiling) and return the program
+    Shader& get()
+    {
+        if (!state->finished)
+        {
+            state->shader.finish(state->pending, state->cache, state->cacheKey);
+            state->finished = true;
+            Shader::reportBuild(false, state->name, state->submitted);
+        }
+        return state->shader;
+    }
+
+private:
+    friend class ShaderCompiler;
+
+    struct State
+    {
+        Shader shader;
+        Shader::Pending pending;
+        const ProgramCache *cache = NULL;
+        uint64_t cacheKey = 0;
+        bool finished = false;
+        std::string name;
+        std::chrono::steady_clock::time_point submitted;
+    };
+    std::shared_ptr<State> state;
+};
+
+// Queues every stage of many programs before anyone reads a status back.
+// With KHR_parallel_shader_compile the driver compiles them on its own threads.
+class ShaderCompiler
+{
+public:
+    explicit ShaderCompiler(const ProgramCache *cache = NULL) : cache(cache)
+    {
+        // let the driver pick as many compiler threads as it likes
+        if (glExt().hasParallelShaderCompile())
+            glExt().MaxShaderCompilerThreads(0xFFFFFFFF);
+    }
+
+    ShaderHandle submit(const char *vertexPath, const char *fragmentPath)
+    {
+        ShaderPreprocessor preprocessor;
+        ShaderSource vertexSource = preprocessor.process(vertexPath);
+        ShaderSource fragmentSource = preprocessor.process(fragmentPath);
+        return submit(vertexSource, fragmentSource, std::string(vertexPath) + " + " + fragmentPath);
+    }
+
+    // sources that were already loaded or preprocessed, e.g. by ShaderVariants
+    ShaderHandle submit(const ShaderSource &vertexSource, const ShaderSource &fragmentSource, const std::string &name)
+    {
+        ShaderHandle handle;
+        handle.state = std::make_shared<ShaderHandle::State>();
+        ShaderHandle::State &state = *handle.state;
+        state.submitted = std::chrono::steady_clock::now();
+        state.name = name;
+        state.cache = cache;
+
+        if (!state.shader.checkSources(vertexSource, fragmentSource))
+        {
+            // nothing to compile, the caller reads shader.loadError()
+            state.finished = true;
+        }
+        else if (state.shader.loadCached(vertexSource, fragmentSource, cache, state.cacheKey))
+        {
+            state.finished = true;
+            Shader::reportBuild(true, state.name, state.submitted);
+        }
+        else
+        {
+            state.pending = state.shader.submit(vertexSource, fragmentSource, cache);
+        }
+        // only unfinished programs are tracked, and those get() already finished are let go
+        dropFinished();
+        if (!state.finished)
+            outstanding.push_back(handle);
+        return handle;
+    }
+
+    // finish everything submitted so far, taking whichever program is ready first
+    void finishAll()
+    {
+        dropFinished();
+        while (!outstanding.empty())
+        {
+            bool progressed = false;
+            for (size_t i = 0; i < outstanding.size(); )
+            {
+                if (outstanding[i].ready())
+                {
+                    outstanding[i].get();
+                    outstanding[i] = outstanding.back();
+                    outstanding.pop_back();
+                    progressed = true;
+                }
+                else
+                {
+                    i++;
+                }
+            }
+            // nothing done yet, block on the oldest one
+            if (!progressed)
+            {
+                outstanding.front().get();
+                outstanding.erase(outstanding.begin());
+            }
+        }
+    }
+
+private:
+    void dropFinished()
+    {
+        for (size_t i = 0; i < outstanding.size(); )
+        {
+            if (outstanding[i].state->finished)
+            {
+                outstanding[i] = outstanding.back();
+                outstanding.pop_back();
+            }
+            else
+            {
+                i++;
+            }
+        }
+    }
+
+    const ProgramCache *cache;
+    std::vector<ShaderHandle> outstanding;
+};
+
+#endif
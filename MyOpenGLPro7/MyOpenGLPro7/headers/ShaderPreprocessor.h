@@ -0,0 +1,219 @@
+//
+//  ShaderPreprocessor.h
+//  MyOpenGLPro7
+//
+
+#ifndef SHADER_PREPROCESSOR_H
+#define SHADER_PREPROCESSOR_H
+
+#include "ShaderSource.h"
+#include "Hash.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+// The #defines selecting one specialisation of a shader. Kept sorted by name,
+// so the same set always produces the same text and the same hash.
+class ShaderDefines
+{
+public:
+    ShaderDefines& set(const std::string &name, const std::string &value = "1")
+    {
+        std::vector<std::pair<std::string, std::string> >::iterator it = std::lower_bound(
+            defines.begin(), defines.end(), name,
+            [](const std::pair<std::string, std::string> &d, const std::string &n) { return d.first < n; });
+        if (it != defines.end() && it->first == name)
+            it->second = value;
+        else
+            defines.insert(it, std::make_pair(name, value));
+        return *this;
+    }
+
+    bool empty() const { return defines.empty(); }
+
+    std::string text() const
+    {
+        std::string out;
+        for (size_t i = 0; i < defines.size(); i++)
+            out += "#define " + defines[i].first + " " + defines[i].second + "\n";
+        return out;
+    }
+
+    // "NAME=value NAME=value", for logs
+    std::string summary() const
+    {
+        std::string out;
+        for (size_t i = 0; i < defines.size(); i++)
+            out += (i ? " " : "") + defines[i].first + "=" + defines[i].second;
+        return out;
+    }
+
+    uint64_t hash(uint64_t seed = FNV64_OFFSET) const
+    {
+        uint64_t h = seed;
+        for (size_t i = 0; i < defines.size(); i++)
+        {
+            h = fnv1a64(defines[i].first.c_str(), defines[i].first.size() + 1, h);
+            h = fnv1a64(defines[i].second.c_str(), defines[i].second.size() + 1, h);
+        }
+        return h;
+    }
+
+private:
+    std::vector<std::pair<std::string, std::string> > defines;
+};
+
+// Resolves #include "file" (relative to the including file, each file at most
+// once) and injects #defines right after #version. #line directives keep the
+// driver's error messages pointing at the original file and line; the source
+// string number is the file's position in the order it was first included.
+// A file without includes and without defines is passed through still mapped.
+class ShaderPreprocessor
+{
+public:
+    ShaderSource process(const char *path, const ShaderDefines &defines = ShaderDefines())
+    {
+        files.assign(1, path);
+        stack.clear();
+        ShaderSource root(path);
+        if (!root.ok())
+            return root;
+        if (defines.empty() && !hasInclude(root.data(), root.length()))
+            return root;
+
+        files.clear();
+        error = ShaderSourceError();
+        std::string out;
+        if (!expand(path, root, out))
+            return ShaderSource::failed(error);
+        injectDefines(out, defines);
+        return ShaderSource::fromCode(path, out);
+    }
+
+    // every file the last process() call read, the root first
+    const std::vector<std::string>& dependencies() const { return files; }
+
+private:
+    std::vector<std::string> files;
+    std::vector<std::string> stack;
+    ShaderSourceError error;
+
+    static bool hasInclude(const char *data, size_t length)
+    {
+        static const char directive[] = "#include";
+        const size_t n = sizeof(directive) - 1;
+        for (size_t i = 0; i + n <= length; i++)
+            if (data[i] == '#' && memcmp(data + i, directive, n) == 0)
+                return true;
+        return false;
+    }
+
+    static std::string directoryOf(const std::string &path)
+    {
+        size_t slash = path.find_last_of('/');
+        return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+    }
+
+    static std::string lineDirective(size_t line, size_t file)
+    {
+        return "#line " + std::to_string(line) + " " + std::to_string(file) + "\n";
+    }
+
+    bool expand(const std::string &path, const ShaderSource &source, std::string &out)
+    {
+        size_t fileIndex = files.size();
+        files.push_back(path);
+        stack.push_back(path);
+
+        const char *data = source.data();
+        size_t length = source.length();
+        size_t lineNumber = 0;
+        for (size_t begin = 0; begin < length; )
+        {
+            size_t end = begin;
+            while (end < length && data[end] != '\n')
+                end++;
+            lineNumber++;
+
+            size_t p = begin;
+            while (p < end && (data[p] == ' ' || data[p] == '\t'))
+                p++;
+            if (end - p >= 8 && memcmp(data + p, "#include", 8) == 0)
+            {
+                // #include "name" or #include <name>
+                size_t open = p + 8;
+                while (open < end && (data[open] == ' ' || data[open] == '\t'))
+                    open++;
+                char closing = open < end && data[open] == '<' ? '>' : '"';
+                size_t close = open + 1;
+                while (close < end && data[close] != closing)
+                    close++;
+                if (open >= end || (data[open] != '"' && data[open] != '<') || close >= end)
+                {
+                    error.status = SOURCE_BAD_DIRECTIVE;
+                    error.path = path;
+                    return false;
+                }
+                std::string includePath = directoryOf(path) + std::string(data + open + 1, close - open - 1);
+                if (std::find(stack.begin(), stack.end(), includePath) != stack.end())
+                {
+                    error.status = SOURCE_INCLUDE_CYCLE;
+                    error.path = includePath;
+                    return false;
+                }
+                if (std::find(files.begin(), files.end(), includePath) == files.end())
+                {
+                    ShaderSource included(includePath.c_str());
+                    if (!included.ok())
+                    {
+                        error = included.status();
+                        return false;
+                    }
+                    out += lineDirective(1, files.size());
+                    if (!expand(includePath, included, out))
+                        return false;
+                    out += lineDirective(lineNumber + 1, fileIndex);
+                }
+                else
+                {
+                    // already included once, keep the line count intact
+                    out += '\n';
+                }
+            }
+            else
+            {
+                out.append(data + begin, end - begin);
+                out += '\n';
+            }
+            begin = end + 1;
+        }
+        stack.pop_back();
+        return true;
+    }
+
+    // defines must follow #version, which has to stay the first directive
+    static void injectDefines(std::string &out, const ShaderDefines &defines)
+    {
+        if (defines.empty())
+            return;
+        size_t lineNumber = 1;
+        for (size_t begin = 0; begin < out.size(); lineNumber++)
+        {
+            size_t end = out.find('\n', begin);
+            if (end == std::string::npos)
+                end = out.size();
+            size_t p = out.find_first_not_of(" \t", begin);
+            if (p != std::string::npos && p < end && out.compare(p, 8, "#version") == 0)
+            {
+                out.insert(end + 1, defines.text() + lineDirective(lineNumber + 1, 0));
+                return;
+            }
+            begin = end + 1;
+        }
+        out.insert(0, defines.text() + lineDirective(1, 0));
+    }
+};
+
+#endif
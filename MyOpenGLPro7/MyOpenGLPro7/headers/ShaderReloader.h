@@ -0,0 +1,229 @@
+//
+//  ShaderReloader.h
+//  MyOpenGLPro7
+//
+
+#ifndef SHADER_RELOADER_H
+#define SHADER_RELOADER_H
+
+#include <glad/glad.h>
+#include "Shader.h"
+#include "ShaderCompiler.h"
+#include "ShaderPreprocessor.h"
+#include "ShaderSource.h"
+#include "ProgramCache.h"
+#include "FileWatcher.h"
+#include "GLExtensions.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Rebuilds watched programs when one of their files (includes too) changes.
+// Reading and preprocessing happen on the watcher thread; the render thread
+// only submits the compile in update() and, with KHR_parallel_shader_compile,
+// keeps drawing with the old program until the new one is done. The program
+// is swapped only if it links, otherwise the old one stays and the log is printed.
+class ShaderReloader
+{
+public:
+    struct Stats
+    {
+        int reloads = 0;
+        int failures = 0;
+        // file change noticed -> new program in use
+        double lastLatencyMs = 0.0;
+        double averageLatencyMs = 0.0;
+    };
+
+    explicit ShaderReloader(const ProgramCache *cache = NULL)
+        : cache(cache), watcher([this](const std::vector<std::string> &changed) { onFilesChanged(changed); })
+    {
+    }
+
+    ShaderReloader(const ShaderReloader&) = delete;
+    ShaderReloader& operator=(const ShaderReloader&) = delete;
+
+    void watch(const ShaderHandle &handle, const char *vertexPath, const char *fragmentPath, const ShaderDefines &defines = ShaderDefines())
+    {
+        std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+        entry->handle = handle;
+        entry->vertexPath = vertexPath;
+        entry->fragmentPath = fragmentPath;
+        entry->defines = defines;
+        // run the preprocessor once just to learn the include files
+        ShaderPreprocessor preprocessor;
+        preprocessor.process(vertexPath, defines);
+        entry->dependencies = preprocessor.dependencies();
+        preprocessor.process(fragmentPath, defines);
+        entry->dependencies.insert(entry->dependencies.end(), preprocessor.dependencies().begin(), preprocessor.dependencies().end());
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            entries.push_back(entry);
+        }
+        for (size_t i = 0; i < entry->dependencies.size(); i++)
+            watcher.watch(entry->dependencies[i]);
+    }
+
+    // call once per frame on the render thread, before drawing
+    void update()
+    {
+        std::vector<Prepared> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.swap(prepared);
+        }
+        for (size_t i = 0; i < ready.size(); i++)
+            submit(ready[i]);
+
+        for (size_t i = 0; i < inFlight.size(); )
+        {
+            InFlight &job = inFlight[i];
+            if (glExt().hasParallelShaderCompile())
+            {
+                GLint done = GL_FALSE;
+                glGetProgramiv(job.fresh.ID, GL_COMPLETION_STATUS_KHR, &done);
+                if (done != GL_TRUE)
+                {
+                    i++;
+                    continue;
+                }
+            }
+            if (job.fresh.finish(job.pending, cache, job.cacheKey))
+                swap(*job.entry, job.fresh, job.detected);
+            else
+                fail(*job.entry, job.fresh);
+            inFlight.erase(inFlight.begin() + i);
+        }
+    }
+
+    const Stats& stats() const { return statistics; }
+
+private:
+    struct Entry
+    {
+        ShaderHandle handle;
+        std::string vertexPath;
+        std::string fragmentPath;
+        ShaderDefines defines;
+        std::vector<std::string> dependencies;
+    };
+
+    // sources read and preprocessed off the render thread
+    struct Prepared
+    {
+        std::shared_ptr<Entry> entry;
+        std::shared_ptr<ShaderSource> vertexSource;
+        std::shared_ptr<ShaderSource> fragmentSource;
+        std::chrono::steady_clock::time_point detected;
+    };
+
+    struct InFlight
+    {
+        std::shared_ptr<Entry> entry;
+        Shader fresh;
+        Shader::Pending pending;
+        uint64_t cacheKey;
+        std::chrono::steady_clock::time_point detected;
+    };
+
+    const ProgramCache *cache;
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Entry> > entries;
+    std::vector<Prepared> prepared;
+    std::vector<InFlight> inFlight;
+    Stats statistics;
+    // last member, so its thread stops before the state it calls back into goes away
+    FileWatcher watcher;
+
+    // watcher thread
+    void onFilesChanged(const std::vector<std::string> &changed)
+    {
+        std::chrono::steady_clock::time_point detected = std::chrono::steady_clock::now();
+        std::vector<std::shared_ptr<Entry> > affected;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 0; i < entries.size(); i++)
+            {
+                const std::vector<std::string> &deps = entries[i]->dependencies;
+                for (size_t c = 0; c < changed.size(); c++)
+                {
+                    if (std::find(deps.begin(), deps.end(), changed[c]) != deps.end())
+                    {
+                        affected.push_back(entries[i]);
+                        break;
+                    }
+                }
+            }
+        }
+
+        for (size_t i = 0; i < affected.size(); i++)
+        {
+            Entry &entry = *affected[i];
+            ShaderPreprocessor preprocessor;
+            Prepared job;
+            job.entry = affected[i];
+            job.detected = detected;
+            job.vertexSource = std::make_shared<ShaderSource>(preprocessor.process(entry.vertexPath.c_str(), entry.defines));
+            std::vector<std::string> dependencies = preprocessor.dependencies();
+            job.fragmentSource = std::make_shared<ShaderSource>(preprocessor.process(entry.fragmentPath.c_str(), entry.defines));
+            dependencies.insert(dependencies.end(), preprocessor.dependencies().begin(), preprocessor.dependencies().end());
+
+            // an edit may have added an include
+            for (size_t d = 0; d < dependencies.size(); d++)
+                watcher.watch(dependencies[d]);
+            std::lock_guard<std::mutex> lock(mutex);
+            entry.dependencies = dependencies;
+            prepared.push_back(job);
+        }
+    }
+
+    // render thread
+    void submit(const Prepared &job)
+    {
+        InFlight flight;
+        flight.entry = job.entry;
+        flight.detected = job.detected;
+        flight.cacheKey = 0;
+        if (!flight.fresh.checkSources(*job.vertexSource, *job.fragmentSource))
+        {
+            std::cout << "ERROR::SHADER::RELOAD " << flight.fresh.loadError().describe() << std::endl;
+            statistics.failures++;
+            return;
+        }
+        if (flight.fresh.loadCached(*job.vertexSource, *job.fragmentSource, cache, flight.cacheKey))
+        {
+            swap(*job.entry, flight.fresh, job.detected);
+            return;
+        }
+        flight.pending = flight.fresh.submit(*job.vertexSource, *job.fragmentSource, cache);
+        inFlight.push_back(flight);
+    }
+
+    void swap(Entry &entry, Shader &fresh, std::chrono::steady_clock::time_point detected)
+    {
+        // make sure the original build is finished before replacing it
+        Shader &target = entry.handle.get();
+        target.swapProgram(fresh);
+
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - detected).count();
+        statistics.reloads++;
+        statistics.lastLatencyMs = ms;
+        statistics.averageLatencyMs += (ms - statistics.averageLatencyMs) / statistics.reloads;
+        std::cout << "SHADER::RELOAD " << entry.vertexPath << " + " << entry.fragmentPath << " in " << ms << " ms" << std::endl;
+    }
+
+    void fail(Entry &entry, Shader &fresh)
+    {
+        glDeleteProgram(fresh.ID);
+        fresh.ID = 0;
+        statistics.failures++;
+        std::cout << "ERROR::SHADER::RELOAD " << entry.vertexPath << " + " << entry.fragmentPath << " failed, keeping the old program" << std::endl;
+    }
+};
+
+#endif
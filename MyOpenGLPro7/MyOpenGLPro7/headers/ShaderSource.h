@@ -0,0 +1,197 @@
+//
+//  ShaderSource.h
+//  MyOpenGLPro7
+//
+
+#ifndef SHADER_SOURCE_H
+#define SHADER_SOURCE_H
+
+#include <glad/glad.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+enum ShaderSourceStatus {
+    SOURCE_OK,
+    SOURCE_NOT_FOUND,
+    SOURCE_READ_FAILED,
+    SOURCE_EMPTY,
+    SOURCE_INCLUDE_CYCLE,
+    SOURCE_BAD_DIRECTIVE
+};
+
+// Why a shader file could not be loaded
+struct ShaderSourceError
+{
+    ShaderSourceStatus status = SOURCE_OK;
+    std::string path;
+    // errno of the failing open/stat/read, 0 if none
+    int errnum = 0;
+
+    std::string describe() const
+    {
+        std::string text;
+        switch (status)
+        {
+            case SOURCE_OK: return "ok";
+            case SOURCE_NOT_FOUND: text = "shader file not found: "; break;
+            case SOURCE_READ_FAILED: text = "could not read shader file: "; break;
+            case SOURCE_EMPTY: text = "shader file is empty: "; break;
+            case SOURCE_INCLUDE_CYCLE: text = "shader file includes itself: "; break;
+            case SOURCE_BAD_DIRECTIVE: text = "malformed #include in shader file: "; break;
+        }
+        text += path;
+        if (errnum)
+            text += std::string(" (") + strerror(errnum) + ")";
+        return text;
+    }
+};
+
+// A read-only view of a whole shader file. The file is memory-mapped and its
+// bytes go to glShaderSource as pointer + length without being copied; if
+// mapping is not possible the file is read once into an owned buffer.
+class ShaderSource
+{
+public:
+    ShaderSource() {}
+
+    explicit ShaderSource(const char *path)
+    {
+        error.path = path;
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            fail(errno == ENOENT ? SOURCE_NOT_FOUND : SOURCE_READ_FAILED, errno);
+            return;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0)
+        {
+            fail(SOURCE_READ_FAILED, errno);
+            close(fd);
+            return;
+        }
+        if (info.st_size == 0)
+        {
+            fail(SOURCE_EMPTY, 0);
+            close(fd);
+            return;
+        }
+        size = (size_t)info.st_size;
+        void *view = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view != MAP_FAILED)
+        {
+            mapping = (const char*)view;
+        }
+        else
+        {
+            buffer.resize(size);
+            size_t got = 0;
+            while (got < size)
+            {
+                ssize_t n = read(fd, &buffer[got], size - got);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                {
+                    fail(n < 0 ? SOURCE_READ_FAILED : SOURCE_EMPTY, n < 0 ? errno : 0);
+                    break;
+                }
+                got += (size_t)n;
+            }
+        }
+        close(fd);
+    }
+
+    // an in-memory source, e.g. the output of ShaderPreprocessor
+    static ShaderSource fromCode(const std::string &name, std::string code)
+    {
+        ShaderSource source;
+        source.error.path = name;
+        source.buffer.swap(code);
+        source.size = source.buffer.size();
+        if (source.size == 0)
+            source.error.status = SOURCE_EMPTY;
+        return source;
+    }
+
+    static ShaderSource failed(const ShaderSourceError &error)
+    {
+        ShaderSource source;
+        source.error = error;
+        return source;
+    }
+
+    ~ShaderSource()
+    {
+        unmap();
+    }
+
+    ShaderSource(const ShaderSource&) = delete;
+    ShaderSource& operator=(const ShaderSource&) = delete;
+
+    ShaderSource(ShaderSource &&other)
+    {
+        *this = std::move(other);
+    }
+
+    ShaderSource& operator=(ShaderSource &&other)
+    {
+        if (this != &other)
+        {
+            unmap();
+            mapping = other.mapping;
+            size = other.size;
+            buffer.swap(other.buffer);
+            error = other.error;
+            other.mapping = NULL;
+            other.size = 0;
+        }
+        return *this;
+    }
+
+    bool ok() const { return error.status == SOURCE_OK; }
+    const ShaderSourceError& status() const { return error; }
+
+    // not null-terminated, always pair with length()
+    const char* data() const { return mapping ? mapping : (buffer.empty() ? "" : &buffer[0]); }
+    size_t length() const { return size; }
+
+    // hand the bytes to a shader object without an intermediate copy
+    void upload(GLuint shader) const
+    {
+        const GLchar *code = data();
+        GLint codeLength = (GLint)size;
+        glShaderSource(shader, 1, &code, &codeLength);
+    }
+
+private:
+    const char *mapping = NULL;
+    size_t size = 0;
+    std::string buffer;
+    ShaderSourceError error;
+
+    void fail(ShaderSourceStatus status, int errnum)
+    {
+        error.status = status;
+        error.errnum = errnum;
+        unmap();
+        buffer.clear();
+        size = 0;
+    }
+
+    void unmap()
+    {
+        if (mapping)
+            munmap((void*)mapping, size);
+        mapping = NULL;
+    }
+};
+
+#endif
@@ -0,0 +1,68 @@
+//
+//  ShaderVariants.h
+//  MyOpenGLPro7
+//
+
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include "ShaderCompiler.h"
+#include "ShaderPreprocessor.h"
+#include "ShaderReloader.h"
+#include "Hash.h"
+
+#include <string>
+#include <unordered_map>
+
+// Hands out specialised programs built from one pair of source files and a
+// set of #defines. Requests are looked up by permutation key first; a new
+// permutation whose preprocessed text matches an existing program (say a
+// define neither stage uses) shares that program instead of compiling again.
+class ShaderVariants
+{
+public:
+    // with a reloader, every program built here is rebuilt when its files change
+    explicit ShaderVariants(ShaderCompiler &compiler, ShaderReloader *reloader = NULL) : compiler(compiler), reloader(reloader) {}
+
+    ShaderHandle request(const char *vertexPath, const char *fragmentPath, const ShaderDefines &defines = ShaderDefines())
+    {
+        uint64_t permutation = defines.hash(fnv1a64(std::string(vertexPath) + '\n' + fragmentPath));
+        std::unordered_map<uint64_t, ShaderHandle>::iterator known = byPermutation.find(permutation);
+        if (known != byPermutation.end())
+            return known->second;
+
+        ShaderSource vertexSource = preprocessor.process(vertexPath, defines);
+        ShaderSource fragmentSource = preprocessor.process(fragmentPath, defines);
+        uint64_t code = fnv1a64(vertexSource.data(), vertexSource.length());
+        code = fnv1a64(fragmentSource.data(), fragmentSource.length(), fnv1a64("", 1, code));
+
+        bool valid = vertexSource.ok() && fragmentSource.ok();
+        std::unordered_map<uint64_t, ShaderHandle>::iterator same = byCode.find(code);
+        if (valid && same != byCode.end())
+            return byPermutation[permutation] = same->second;
+
+        std::string name = std::string(vertexPath) + " + " + fragmentPath;
+        if (!defines.empty())
+            name += " [" + defines.summary() + "]";
+        ShaderHandle handle = compiler.submit(vertexSource, fragmentSource, name);
+        byPermutation[permutation] = handle;
+        if (valid)
+            byCode[code] = handle;
+        if (valid && reloader)
+            reloader->watch(handle, vertexPath, fragmentPath, defines);
+        return handle;
+    }
+
+    // distinct permutations requested vs programs actually built
+    size_t permutationCount() const { return byPermutation.size(); }
+    size_t programCount() const { return byCode.size(); }
+
+private:
+    ShaderCompiler &compiler;
+    ShaderReloader *reloader;
+    ShaderPreprocessor preprocessor;
+    std::unordered_map<uint64_t, ShaderHandle> byPermutation;
+    std::unordered_map<uint64_t, ShaderHandle> byCode;
+};
+
+#endif
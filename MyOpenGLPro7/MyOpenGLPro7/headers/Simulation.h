@@ -0,0 +1,305 @@
+//
+//  Simulation.h
+//  MyOpenGLPro7
+//
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "../glm/glm/glm.hpp"
+#include "../glm/glm/gtc/matrix_transform.hpp"
+#include "camera.h"
+#include "CameraPath.h"
+#include "CubeTransforms.h"
+#include "Frustum.h"
+#include "InputQueue.h"
+#include "InputRecording.h"
+#include "JobSystem.h"
+#include "SceneBVH.h"
+#include "TripleBuffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// where the camera is and how it looks, enough to rebuild its matrices
+struct CameraState
+{
+    glm::vec3 position;
+    glm::vec3 front = glm::vec3(0.0f, 0.0f, -1.0f);
+    glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+    float zoom = ZOOM;
+    float nearPlane = 0.1f;
+    float farPlane = 100.0f;
+    Camera::DepthMode depth = Camera::DEPTH_STANDARD;
+
+    static CameraState of(const Camera &camera)
+    {
+        CameraState state;
+        state.position = camera.Position;
+        state.front = camera.Front;
+        state.up = camera.Up;
+        state.zoom = camera.Zoom;
+        state.nearPlane = camera.Near;
+        state.farPlane = camera.Far;
+        state.depth = camera.Depth;
+        return state;
+    }
+
+    glm::mat4 view() const { return glm::lookAt(position, position + front, up); }
+    glm::mat4 project(float aspect) const { return Camera::BuildProjection(zoom, aspect, nearPlane, farPlane, depth); }
+
+    // blend towards next by alpha in [0, 1]
+    CameraState mix(const CameraState &next, float alpha) const
+    {
+        CameraState state;
+        state.position = glm::mix(position, next.position, alpha);
+        state.front = glm::normalize(glm::mix(front, next.front, alpha));
+        state.up = glm::normalize(glm::mix(up, next.up, alpha));
+        state.zoom = glm::mix(zoom, next.zoom, alpha);
+        state.nearPlane = next.nearPlane;
+        state.farPlane = next.farPlane;
+        state.depth = next.depth;
+        return state;
+    }
+};
+
+// The last two simulation steps, written by the simulation and never changed
+// after it is published; the render thread blends between them.
+struct FrameSnapshot
+{
+    // simulated seconds at the two steps
+    float previousTime = 0.0f;
+    float time = 0.0f;
+    CameraState previousCamera;
+    CameraState camera;
+    // model matrices of the cubes inside the view frustum, at both steps
+    std::vector<glm::mat4> previousModels;
+    std::vector<glm::mat4> models;
+    // seconds after Simulation::start() at which the last step was due
+    double dueAt = 0.0;
+
+    float timeAt(float alpha) const { return previousTime + (time - previousTime) * alpha; }
+    CameraState cameraAt(float alpha) const { return previousCamera.mix(camera, alpha); }
+    // a step turns the cubes by a tiny angle, so blending the matrices stays rigid to float precision
+    glm::mat4 modelAt(size_t i, float alpha) const
+    {
+        glm::mat4 model;
+        for (int column = 0; column < 4; column++)
+            model[column] = glm::mix(previousModels[i][column], models[i][column], alpha);
+        return model;
+    }
+};
+
+// Runs camera movement, cube animation, culling and picking in fixed steps
+// of 1 / STEP_RATE seconds on a thread of its own, so motion no longer
+// depends on the frame rate and a slow frame on either side never stalls the
+// other. Real time is accumulated and paid out in whole steps; input comes in
+// through a lock-free event queue drained once per step, and snapshots go out
+// through a lock-free triple buffer. Every step depends
+// only on the previous state and the input it saw, so a recording of those
+// inputs replays the session exactly, also headless through replay().
+// From start() to stop() the simulation owns the camera, the transforms, the
+// BVH and the job system it was given; the main thread must not touch them.
+class Simulation
+{
+public:
+    // simulation steps per second
+    static const int STEP_RATE = 120;
+    // after a stall, catch up at most this many steps and drop the rest of the backlog
+    static const int MAX_CATCH_UP = 8;
+
+    Simulation(Camera &camera, CubeTransforms &transforms, SceneBVH &bvh, const BVHMesh &cubeMesh, JobSystem &jobs, float aspect)
+        : camera(camera), transforms(transforms), bvh(bvh), cubeMesh(cubeMesh), jobs(jobs), running(false)
+    {
+        camera.SetProjection(aspect, 0.1f, 100.0f);
+        lastCamera = CameraState::of(camera);
+    }
+
+    ~Simulation()
+    {
+        stop();
+    }
+
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    // every step's input is appended here until stop(), along with the camera's depth mode; set before start()
+    void record(InputRecording *recording)
+    {
+        recorder = recording;
+        recording->setReversedDepth(camera.Depth == Camera::DEPTH_REVERSED);
+    }
+
+    // the camera's pose is added here every step until stop(), thinned to the path's key interval; set before start()
+    void recordPath(CameraPath *path)
+    {
+        pathRecorder = path;
+    }
+
+    // the camera flies along path instead of following input, by simulated time; set before start()
+    void follow(const CameraPath *path)
+    {
+        flightPath = path;
+    }
+
+    void start()
+    {
+        if (running)
+            return;
+        running = true;
+        epoch = Clock::now();
+        thread = std::thread(&Simulation::run, this);
+    }
+
+    void stop()
+    {
+        if (!running)
+            return;
+        running = false;
+        thread.join();
+    }
+
+    // main thread: where the input callbacks send their events
+    InputQueue& input() { return inputs; }
+
+    // render thread: the newest snapshot, or the previous one again if the simulation has not stepped since
+    const FrameSnapshot& latestFrame()
+    {
+        frames.update();
+        return frames.readBuffer();
+    }
+
+    // render thread: how far to blend from the snapshot's previous step to its last one right now;
+    // the screen runs one step behind the simulation so there is always a step to blend towards
+    float blend(const FrameSnapshot &frame) const
+    {
+        double now = std::chrono::duration<double>(Clock::now() - epoch).count();
+        double alpha = (now - frame.dueAt) * STEP_RATE;
+        return (float)std::min(std::max(alpha, 0.0), 1.0);
+    }
+
+    // run every step of recording on the calling thread, as fast as possible; not while started
+    double replay(const InputRecording &recording)
+    {
+        Clock::time_point begin = Clock::now();
+        for (size_t i = 0; i < recording.size(); i++)
+            step(recording[i]);
+        return std::chrono::duration<double>(Clock::now() - begin).count();
+    }
+
+    uint64_t steps() const { return stepCount; }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Camera &camera;
+    CubeTransforms &transforms;
+    SceneBVH &bvh;
+    const BVHMesh &cubeMesh;
+    JobSystem &jobs;
+    std::atomic<bool> running;
+    std::thread thread;
+    Clock::time_point epoch;
+    InputQueue inputs;
+    // what inputs delivered for the current step
+    InputState liveInput;
+    TripleBuffer<FrameSnapshot> frames;
+    InputRecording *recorder = NULL;
+    CameraPath *pathRecorder = NULL;
+    const CameraPath *flightPath = NULL;
+    CameraState lastCamera;
+    uint64_t stepCount = 0;
+    // seconds of real time skipped after stalls, so dueAt keeps up with the clock
+    double dropped = 0.0;
+    std::vector<uint32_t> visible;
+
+    void run()
+    {
+        const double stepSeconds = 1.0 / STEP_RATE;
+        Clock::time_point last = epoch;
+        double accumulator = 0.0;
+        while (running)
+        {
+            Clock::time_point now = Clock::now();
+            accumulator += std::chrono::duration<double>(now - last).count();
+            last = now;
+            if (accumulator > MAX_CATCH_UP * stepSeconds)
+            {
+                dropped += accumulator - MAX_CATCH_UP * stepSeconds;
+                accumulator = MAX_CATCH_UP * stepSeconds;
+            }
+
+            while (accumulator >= stepSeconds)
+            {
+                inputs.drain(liveInput);
+                step(liveInput);
+                if (recorder)
+                    recorder->add(liveInput);
+                accumulator -= stepSeconds;
+            }
+            // wake when the next step is due
+            std::this_thread::sleep_until(now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(stepSeconds - accumulator)));
+        }
+    }
+
+    // one fixed step; time comes from the step count, never from the clock
+    void step(const InputState &input)
+    {
+        const float stepSeconds = 1.0f / STEP_RATE;
+        if (flightPath)
+            flightPath->apply((float)((double)(stepCount + 1) / STEP_RATE), camera);
+        else
+        {
+            for (int i = 0; i < 4; i++)
+                if (input.moves[i])
+                    camera.ProcessKeyboard((Camera_Movement)i, stepSeconds);
+            if (input.lookX != 0.0f || input.lookY != 0.0f)
+                camera.ProcessMouseMovement(input.lookX, input.lookY);
+            if (input.scroll != 0.0f)
+                camera.ProcessMouseScroll(input.scroll);
+        }
+
+        FrameSnapshot &frame = frames.writeBuffer();
+        frame.previousTime = (float)((double)stepCount / STEP_RATE);
+        stepCount++;
+        frame.time = (float)((double)stepCount / STEP_RATE);
+        frame.dueAt = (double)stepCount / STEP_RATE + dropped;
+        frame.previousCamera = lastCamera;
+        frame.camera = CameraState::of(camera);
+
+        // skip cubes outside the view, then build matrices for the rest only
+        Frustum frustum = Frustum::fromMatrix(camera.GetViewProjectionMatrix(), camera.Depth == Camera::DEPTH_REVERSED);
+        cullSpheres(frustum, transforms.positionsX(), transforms.positionsY(), transforms.positionsZ(),
+                    transforms.boundingRadii(), transforms.size(), visible);
+        transforms.update(jobs, frame.previousTime, frame.time, visible);
+        frame.previousModels.assign(transforms.previousData(), transforms.previousData() + transforms.modelCount());
+        frame.models.assign(transforms.data(), transforms.data() + transforms.modelCount());
+        float time = frame.time;
+        frames.publish();
+        if (pathRecorder)
+            pathRecorder->add(time, camera);
+
+        if (input.picks)
+            pick(time);
+        lastCamera = CameraState::of(camera);
+    }
+
+    // the cube under the crosshair, with exact triangles at their current rotation
+    void pick(float time)
+    {
+        for (size_t i = 0; i < bvh.size(); i++)
+            bvh.setMesh(i, &cubeMesh, transforms.model(i, time));
+        SceneBVH::RayHit hit;
+        if (bvh.raycast(camera.Position, camera.Front, 100.0f, hit))
+            std::cout << "PICK cube " << hit.object << " triangle " << hit.triangle << " at " << hit.distance << std::endl;
+        else
+            std::cout << "PICK nothing" << std::endl;
+    }
+};
+
+#endif
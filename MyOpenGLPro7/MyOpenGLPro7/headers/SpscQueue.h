@@ -0,0 +1,60 @@
+//
+//  SpscQueue.h
+//  MyOpenGLPro7
+//
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// A fixed ring that passes values in order from exactly one producer thread
+// to exactly one consumer thread without locks. The producer only writes
+// tail, the consumer only writes head, so each side needs one acquire load
+// of the other's index per call. CAPACITY must be a power of two; one slot
+// stays empty to tell a full ring from an empty one.
+template <typename T, size_t CAPACITY>
+class SpscQueue
+{
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // producer side: false if the ring is full and value was not queued
+    bool push(const T &value)
+    {
+        size_t back = tail.load(std::memory_order_relaxed);
+        size_t next = (back + 1) & MASK;
+        if (next == head.load(std::memory_order_acquire))
+            return false;
+        slots[back] = value;
+        tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side: false if there was nothing to take
+    bool pop(T &value)
+    {
+        size_t front = head.load(std::memory_order_relaxed);
+        if (front == tail.load(std::memory_order_acquire))
+            return false;
+        value = slots[front];
+        head.store((front + 1) & MASK, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0, "SpscQueue capacity must be a power of two");
+    static const size_t MASK = CAPACITY - 1;
+
+    T slots[CAPACITY];
+    // the consumer's and the producer's index on separate cache lines
+    std::atomic<size_t> head;
+    char headPadding[64];
+    std::atomic<size_t> tail;
+};
+
+#endif
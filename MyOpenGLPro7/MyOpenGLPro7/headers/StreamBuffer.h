@@ -0,0 +1,203 @@
+//
+//  StreamBuffer.h
+//  MyOpenGLPro7
+//
+
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <glad/glad.h>
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// One buffer for data rewritten every frame (uniforms, instance data, UI
+// vertices), split into FRAMES regions. Each frame sub-allocates from its own
+// region; endFrame() fences it, and the region is only written again once
+// that fence has passed, so the driver never has to synchronise implicitly.
+// With GL 4.4 / ARB_buffer_storage the buffer stays persistently and
+// coherently mapped; otherwise every allocation maps its range unsynchronized
+// (the fence already made it safe), and if even that fails it is staged and
+// copied with glBufferSubData on commit().
+class StreamBuffer
+{
+public:
+    // regions in the ring, so the CPU can fill one while the GPU reads the others
+    static const int FRAMES = 3;
+
+    struct Allocation
+    {
+        // write here, then commit()
+        void *data = NULL;
+        // where it lands in buffer(), for binding or attribute pointers
+        GLintptr offset = 0;
+        GLsizeiptr size = 0;
+    };
+
+    explicit StreamBuffer(GLenum target, GLsizeiptr frameCapacity = 0) : target(target)
+    {
+        for (int i = 0; i < FRAMES; i++)
+            fences[i] = 0;
+        if (frameCapacity > 0)
+            create(frameCapacity);
+    }
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    GLuint buffer() const { return id; }
+    GLsizeiptr frameCapacity() const { return capacity; }
+    bool persistent() const { return mapped != NULL; }
+
+    // make sure one frame can hold bytes; growing waits for the GPU to let go of the old buffer
+    void reserve(GLsizeiptr bytes)
+    {
+        if (bytes <= capacity)
+            return;
+        GLsizeiptr grown = capacity ? capacity : 4096;
+        while (grown < bytes)
+            grown *= 2;
+        destroy();
+        create(grown);
+    }
+
+    // a range of this frame's region; data is NULL if the region is full
+    Allocation allocate(GLsizeiptr bytes, GLsizeiptr alignment = 4)
+    {
+        Allocation allocation;
+        if (!regionReady)
+        {
+            // the GPU may still read this region from FRAMES frames ago
+            waitFence(fences[slot]);
+            regionReady = true;
+        }
+        GLsizeiptr start = (cursor + alignment - 1) / alignment * alignment;
+        if (start + bytes > capacity)
+        {
+            std::cout << "ERROR::STREAM_BUFFER::FULL " << bytes << " bytes requested, " << capacity - cursor << " left this frame" << std::endl;
+            return allocation;
+        }
+        cursor = start + bytes;
+        allocation.offset = capacity * slot + start;
+        allocation.size = bytes;
+        if (mapped)
+        {
+            allocation.data = mapped + allocation.offset;
+            return allocation;
+        }
+        glState().bindBuffer(target, id);
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+        allocation.data = glMapBufferRange(target, allocation.offset, bytes, flags);
+        if (!allocation.data)
+        {
+            staging.resize((size_t)bytes);
+            allocation.data = &staging[0];
+        }
+        return allocation;
+    }
+
+    // the allocation's data is written; a no-op while persistently mapped
+    void commit(const Allocation &allocation)
+    {
+        if (mapped || !allocation.data)
+            return;
+        glState().bindBuffer(target, id);
+        if (!staging.empty() && allocation.data == &staging[0])
+        {
+            glBufferSubData(target, allocation.offset, allocation.size, allocation.data);
+            staging.clear();
+        }
+        else
+        {
+            glUnmapBuffer(target);
+        }
+    }
+
+    // fence this frame's region after the draws that read it and move on
+    void endFrame()
+    {
+        if (regionReady && cursor > 0)
+            fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot = (slot + 1) % FRAMES;
+        cursor = 0;
+        regionReady = false;
+    }
+
+    // must run while the context is still alive
+    void release()
+    {
+        destroy();
+    }
+
+    // block until the GPU passed the fence, then delete it
+    static void waitFence(GLsync &fence)
+    {
+        if (!fence)
+            return;
+        GLbitfield flags = 0;
+        GLuint64 timeout = 0;
+        for (;;)
+        {
+            GLenum result = glClientWaitSync(fence, flags, timeout);
+            if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED)
+                break;
+            // make sure the fence is actually submitted, then block for up to 1ms per try
+            flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+            timeout = 1000000;
+        }
+        glDeleteSync(fence);
+        fence = 0;
+    }
+
+private:
+    GLenum target;
+    GLuint id = 0;
+    GLsizeiptr capacity = 0;
+    char *mapped = NULL;
+    GLsync fences[FRAMES];
+    int slot = 0;
+    GLsizeiptr cursor = 0;
+    bool regionReady = false;
+    std::vector<char> staging;
+
+    void create(GLsizeiptr frameCapacity)
+    {
+        capacity = frameCapacity;
+        glGenBuffers(1, &id);
+        glState().bindBuffer(target, id);
+        if (glExt().hasBufferStorage())
+        {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glExt().BufferStorage(target, capacity * FRAMES, NULL, flags);
+            mapped = (char*)glMapBufferRange(target, 0, capacity * FRAMES, flags);
+        }
+        else
+        {
+            glBufferData(target, capacity * FRAMES, NULL, GL_STREAM_DRAW);
+        }
+        cursor = 0;
+        regionReady = false;
+    }
+
+    void destroy()
+    {
+        for (int i = 0; i < FRAMES; i++)
+            waitFence(fences[i]);
+        if (!id)
+            return;
+        if (mapped)
+        {
+            glState().bindBuffer(target, id);
+            glUnmapBuffer(target);
+            mapped = NULL;
+        }
+        glState().deleteBuffer(id);
+        id = 0;
+        capacity = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,60 @@
+//
+//  TripleBuffer.h
+//  MyOpenGLPro7
+//
+
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// Hands the newest value from one writer thread to one reader thread without
+// locks or waiting. Three slots: the writer owns one, the reader owns one and
+// the third is in between. publish() swaps the writer's slot with the one in
+// between, update() swaps the reader's slot with it if something new arrived,
+// so neither side ever waits for the other and the reader always sees the
+// latest complete value; values nobody read in time are simply overwritten.
+// The slot the writer gets back after publish() holds stale data and must be
+// rewritten completely.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : back(0), middle(1), front(2) {}
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // writer side
+    T& writeBuffer() { return slots[back]; }
+
+    void publish()
+    {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // reader side: take the newest published value, false if there was none since the last call
+    bool update()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH))
+            return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    const T& readBuffer() const { return slots[front]; }
+
+private:
+    static const unsigned int INDEX = 3;
+    static const unsigned int FRESH = 4;
+
+    T slots[3];
+    // keep the writer's, the shared and the reader's index on separate cache lines
+    unsigned int back;
+    char backPadding[64];
+    std::atomic<unsigned int> middle;
+    char middlePadding[64];
+    unsigned int front;
+};
+
+#endif
@@ -0,0 +1,122 @@
+//
+//  UniformTable.h
+//  MyOpenGLPro7
+//
+
+#ifndef UNIFORM_TABLE_H
+#define UNIFORM_TABLE_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// What the driver reported for one active uniform after linking
+struct UniformInfo
+{
+    std::string name;
+    GLint location;
+    GLenum type;
+    GLint size;
+};
+
+// A flat open-addressing hash table (name -> UniformInfo), filled once per program.
+// Lookups hash the name but never go to the driver.
+class UniformTable
+{
+public:
+    void clear()
+    {
+        slots.clear();
+        entries.clear();
+    }
+
+    void insert(const std::string &name, GLint location, GLenum type, GLint size)
+    {
+        // keep the load factor at or below one half so probe chains stay short
+        if ((entries.size() + 1) * 2 > slots.size())
+            rehash(slots.empty() ? 16 : slots.size() * 2);
+
+        uint32_t h = hash(name.c_str(), name.size());
+        size_t i = probe(h, name.c_str(), name.size());
+        if (slots[i].index >= 0)
+        {
+            entries[slots[i].index] = UniformInfo{name, location, type, size};
+            return;
+        }
+        slots[i].hash = h;
+        slots[i].index = (int32_t)entries.size();
+        entries.push_back(UniformInfo{name, location, type, size});
+    }
+
+    // returns NULL when the program has no active uniform with this name
+    const UniformInfo* find(const char *name, size_t length) const
+    {
+        if (slots.empty())
+            return NULL;
+        size_t i = probe(hash(name, length), name, length);
+        return slots[i].index >= 0 ? &entries[slots[i].index] : NULL;
+    }
+    const UniformInfo* find(const std::string &name) const
+    {
+        return find(name.c_str(), name.size());
+    }
+
+    size_t size() const { return entries.size(); }
+    const std::vector<UniformInfo>& all() const { return entries; }
+
+private:
+    struct Slot
+    {
+        uint32_t hash;
+        int32_t index; // into entries, -1 when empty
+    };
+    std::vector<Slot> slots;
+    std::vector<UniformInfo> entries;
+
+    // FNV-1a, good enough for the handful of short names a program has
+    static uint32_t hash(const char *s, size_t length)
+    {
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < length; i++)
+        {
+            h ^= (unsigned char)s[i];
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    // linear probing; returns the matching slot or the empty slot ending the chain
+    size_t probe(uint32_t h, const char *name, size_t length) const
+    {
+        size_t mask = slots.size() - 1;
+        size_t i = h & mask;
+        while (slots[i].index >= 0)
+        {
+            const UniformInfo &e = entries[slots[i].index];
+            if (slots[i].hash == h && e.name.size() == length && memcmp(e.name.c_str(), name, length) == 0)
+                return i;
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    void rehash(size_t capacity)
+    {
+        slots.assign(capacity, Slot{0, -1});
+        size_t mask = capacity - 1;
+        for (size_t n = 0; n < entries.size(); n++)
+        {
+            uint32_t h = hash(entries[n].name.c_str(), entries[n].name.size());
+            size_t i = h & mask;
+            while (slots[i].index >= 0)
+                i = (i + 1) & mask;
+            slots[i].hash = h;
+            slots[i].index = (int32_t)n;
+        }
+    }
+};
+
+#endif
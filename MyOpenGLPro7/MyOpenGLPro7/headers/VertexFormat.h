@@ -0,0 +1,228 @@
+//
+//  VertexFormat.h
+//  MyOpenGLPro7
+//
+
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <glad/glad.h>
+#include "../glm/glm/glm.hpp"
+#include "../glm/glm/gtc/packing.hpp"
+
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VERTEX_FORMAT_SSE2 1
+#endif
+
+// how one attribute is stored in the vertex buffer
+enum VertexAttribType {
+    VERTEX_FLOAT,
+    // 16 bit float, for positions and normals in a modest range
+    VERTEX_HALF,
+    // 16 bit unsigned normalised, for values in [0, 1] such as UVs
+    VERTEX_UNORM16
+};
+
+// Describes an interleaved vertex layout, packs float vertices into it and
+// sets up the matching attribute pointers, so the two can never disagree.
+// Every attribute starts on a 4 byte boundary, e.g. a 3 component half takes 8.
+// With SSE2, packing converts one component of four vertices per register;
+// without it, it falls back to glm's packHalf / packUnorm.
+class VertexFormat
+{
+public:
+    struct Attribute
+    {
+        GLuint location;
+        int components;
+        VertexAttribType type;
+        size_t offset;
+    };
+
+    VertexFormat& add(GLuint location, int components, VertexAttribType type)
+    {
+        Attribute attribute = {location, components, type, bytes};
+        attributes.push_back(attribute);
+        bytes += (size(type, components) + 3) & ~(size_t)3;
+        floats += components;
+        return *this;
+    }
+
+    // bytes per packed vertex
+    GLsizei stride() const { return (GLsizei)bytes; }
+    // floats per vertex pack() reads: every attribute's components, in order
+    size_t sourceFloats() const { return floats; }
+    const std::vector<Attribute>& layout() const { return attributes; }
+
+    // point the bound VAO at the bound GL_ARRAY_BUFFER, starting at byte offset base
+    void apply(size_t base = 0) const
+    {
+        for (size_t i = 0; i < attributes.size(); i++)
+        {
+            const Attribute &a = attributes[i];
+            const void *pointer = (const void*)(base + a.offset);
+            switch (a.type)
+            {
+                case VERTEX_FLOAT: glVertexAttribPointer(a.location, a.components, GL_FLOAT, GL_FALSE, stride(), pointer); break;
+                case VERTEX_HALF: glVertexAttribPointer(a.location, a.components, GL_HALF_FLOAT, GL_FALSE, stride(), pointer); break;
+                case VERTEX_UNORM16: glVertexAttribPointer(a.location, a.components, GL_UNSIGNED_SHORT, GL_TRUE, stride(), pointer); break;
+            }
+            glEnableVertexAttribArray(a.location);
+        }
+    }
+
+    // interleaved floats (sourceFloats() per vertex) to interleaved packed vertices
+    std::vector<unsigned char> pack(const float *vertices, size_t count) const
+    {
+        std::vector<unsigned char> out(count * bytes, 0);
+        size_t source = 0;
+        for (size_t i = 0; i < attributes.size(); i++)
+        {
+            const Attribute &a = attributes[i];
+            packAttribute(a, vertices + source, floats, out.empty() ? NULL : &out[a.offset], bytes, count);
+            source += a.components;
+        }
+        return out;
+    }
+
+private:
+    std::vector<Attribute> attributes;
+    size_t bytes = 0;
+    size_t floats = 0;
+
+    static size_t size(VertexAttribType type, int components)
+    {
+        return (type == VERTEX_FLOAT ? 4 : 2) * (size_t)components;
+    }
+
+    static void packAttribute(const Attribute &a, const float *src, size_t srcStride, unsigned char *dst, size_t dstStride, size_t count)
+    {
+        size_t n = (size_t)a.components;
+        if (a.type == VERTEX_FLOAT)
+        {
+            for (size_t v = 0; v < count; v++)
+                memcpy(dst + v * dstStride, src + v * srcStride, n * sizeof(float));
+            return;
+        }
+        size_t v = 0;
+#ifdef VERTEX_FORMAT_SSE2
+        if (n <= 4)
+        {
+            // four vertices at a time: transpose them so each register holds one
+            // component of all four, convert those, and interleave the results
+            // back into vertex order
+            for (; v + 4 <= count; v += 4)
+            {
+                __m128 rows[4];
+                for (int k = 0; k < 4; k++)
+                    rows[k] = loadComponents(src + (v + k) * srcStride, n);
+                _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+                __m128i components[4] = { _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+                for (size_t c = 0; c < n; c++)
+                    components[c] = narrow16(a.type == VERTEX_HALF ? halfSSE2(rows[c]) : unorm16SSE2(rows[c]));
+                __m128i low = _mm_unpacklo_epi16(components[0], components[1]);
+                __m128i high = _mm_unpacklo_epi16(components[2], components[3]);
+                GLushort out[4][4];
+                _mm_storeu_si128((__m128i*)out[0], _mm_unpacklo_epi32(low, high));
+                _mm_storeu_si128((__m128i*)out[2], _mm_unpackhi_epi32(low, high));
+                for (int k = 0; k < 4; k++)
+                    memcpy(dst + (v + k) * dstStride, out[k], n * sizeof(GLushort));
+            }
+            // the last count % 4 vertices one register each
+            for (; v < count; v++)
+            {
+                __m128 value = loadComponents(src + v * srcStride, n);
+                GLushort out[4];
+                _mm_storel_epi64((__m128i*)out, narrow16(a.type == VERTEX_HALF ? halfSSE2(value) : unorm16SSE2(value)));
+                memcpy(dst + v * dstStride, out, n * sizeof(GLushort));
+            }
+            return;
+        }
+#endif
+        for (; v < count; v++)
+        {
+            const float *in = src + v * srcStride;
+            GLushort out[4];
+            size_t c = 0;
+            // glm packs whole vectors first component lowest, which is memory order here
+            if (n >= 4)
+            {
+                glm::uint64 word = a.type == VERTEX_HALF ? glm::packHalf4x16(glm::vec4(in[0], in[1], in[2], in[3]))
+                                                         : glm::packUnorm4x16(glm::vec4(in[0], in[1], in[2], in[3]));
+                memcpy(out, &word, sizeof(word));
+                c = 4;
+            }
+            else if (n >= 2)
+            {
+                glm::uint word = a.type == VERTEX_HALF ? glm::packHalf2x16(glm::vec2(in[0], in[1]))
+                                                       : glm::packUnorm2x16(glm::vec2(in[0], in[1]));
+                memcpy(out, &word, sizeof(word));
+                c = 2;
+            }
+            for (; c < n && c < 4; c++)
+                out[c] = a.type == VERTEX_HALF ? glm::packHalf1x16(in[c]) : glm::packUnorm1x16(in[c]);
+            memcpy(dst + v * dstStride, out, (n < 4 ? n : 4) * sizeof(GLushort));
+        }
+    }
+
+#ifdef VERTEX_FORMAT_SSE2
+    // n <= 4 floats into the low lanes, zeros above
+    static __m128 loadComponents(const float *in, size_t n)
+    {
+        float lanes[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        memcpy(lanes, in, n * sizeof(float));
+        return _mm_loadu_ps(lanes);
+    }
+
+    // four floats to four halves (in the low 16 bits of each lane), rounding
+    // to nearest; overflow becomes infinity and NaN stays NaN. After
+    // Fabian Giesen's float_to_half_SSE2.
+    static __m128i halfSSE2(__m128 f)
+    {
+        const __m128i signMask = _mm_set1_epi32((int)0x80000000u);
+        const __m128i roundMask = _mm_set1_epi32(~0xfff);
+        const __m128i f32Infinity = _mm_set1_epi32(255 << 23);
+        const __m128i magic = _mm_set1_epi32(15 << 23);
+        const __m128i nanBit = _mm_set1_epi32(0x200);
+        const __m128i f16Infinity = _mm_set1_epi32(0x7c00);
+        const __m128i clamp = _mm_set1_epi32((31 << 23) - 0x1000);
+
+        __m128 sign = _mm_and_ps(_mm_castsi128_ps(signMask), f);
+        __m128 absolute = _mm_xor_ps(f, sign);
+        __m128i absoluteBits = _mm_castps_si128(absolute);
+        __m128i isNaN = _mm_cmpgt_epi32(absoluteBits, f32Infinity);
+        __m128i isFinite = _mm_cmpgt_epi32(f32Infinity, absoluteBits);
+        __m128i infOrNaN = _mm_or_si128(_mm_and_si128(isNaN, nanBit), f16Infinity);
+
+        // rebias the exponent by multiplying, which also flushes tiny values to half denormals
+        __m128 truncated = _mm_and_ps(absolute, _mm_castsi128_ps(roundMask));
+        __m128 scaled = _mm_mul_ps(truncated, _mm_castsi128_ps(magic));
+        __m128 clamped = _mm_min_ps(scaled, _mm_castsi128_ps(clamp));
+        __m128i biased = _mm_sub_epi32(_mm_castps_si128(clamped), roundMask);
+        __m128i finite = _mm_and_si128(_mm_srli_epi32(biased, 13), isFinite);
+        __m128i special = _mm_andnot_si128(isFinite, infOrNaN);
+        return _mm_or_si128(_mm_or_si128(finite, special), _mm_srli_epi32(_mm_castps_si128(sign), 16));
+    }
+
+    // round(clamp(f, 0, 1) * 65535) per lane
+    static __m128i unorm16SSE2(__m128 f)
+    {
+        __m128 clamped = _mm_min_ps(_mm_max_ps(f, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+        return _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_set1_ps(65535.0f)));
+    }
+
+    // low 16 bits of the four lanes into the low 64 bits
+    static __m128i narrow16(__m128i lanes)
+    {
+        lanes = _mm_shufflelo_epi16(lanes, _MM_SHUFFLE(2, 0, 2, 0));
+        lanes = _mm_shufflehi_epi16(lanes, _MM_SHUFFLE(2, 0, 2, 0));
+        return _mm_shuffle_epi32(lanes, _MM_SHUFFLE(2, 0, 2, 0));
+    }
+#endif
+};
+
+#endif
@@ -13,7 +13,9 @@
 #include <glad/glad.h>
 #include "../glm/glm/glm.hpp"
 #include "../glm/glm/gtc/matrix_transform.hpp"
+#include "../glm/glm/gtc/quaternion.hpp"
 
+#include <cmath>
 #include <vector>
 
 // Defines several possible options for camera movement. Used as abstraction to stay away from window-system specific input methods
@@ -32,16 +34,28 @@ const float SENSITIVITY =  0.1f;
 const float ZOOM        =  45.0f;
 
 
-// An abstract camera class that processes input and calculates the corresponding Euler Angles, Vectors and Matrices for use in OpenGL
+// A camera that processes input and keeps its orientation as a quaternion built from the Euler angles.
+// View, projection, view-projection and their inverses are cached and only rebuilt after something they
+// depend on changed, so asking for them many times per frame (culling, picking, shadow cascades) is free.
+// The attributes are public for reading; change them through the Process* and Set* methods so the caches follow.
 class Camera
 {
 public:
+    enum DepthMode {
+        // glm::perspective between Near and Far, GL's -1..1 clip depth
+        DEPTH_STANDARD,
+        // reverse-Z: depth 1 at Near falling to 0 at infinity, Far is ignored; needs glClipControl(GL_LOWER_LEFT,
+        // GL_ZERO_TO_ONE), a depth clear of 0 and GL_GREATER, and keeps precision even far away in a float depth buffer
+        DEPTH_REVERSED
+    };
+    
     // Camera Attributes
     glm::vec3 Position;
     glm::vec3 Front;
     glm::vec3 Up;
     glm::vec3 Right;
     glm::vec3 WorldUp;
+    glm::quat Orientation;
     // Euler Angles
     float Yaw;
     float Pitch;
@@ -49,30 +63,127 @@ public:
     float MovementSpeed;
     float MouseSensitivity;
     float Zoom;
+    // Projection
+    float Aspect;
+    float Near;
+    float Far;
+    DepthMode Depth;
     
     // Constructor with vectors
-    Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
+    Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM), Aspect(4.0f / 3.0f), Near(0.1f), Far(100.0f), Depth(DEPTH_STANDARD)
     {
         Position = position;
-        WorldUp = up;
+        WorldUp = glm::normalize(up);
         Yaw = yaw;
         Pitch = pitch;
         updateCameraVectors();
     }
     // Constructor with scalar values
-    Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
+    Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM), Aspect(4.0f / 3.0f), Near(0.1f), Far(100.0f), Depth(DEPTH_STANDARD)
     {
         Position = glm::vec3(posX, posY, posZ);
-        WorldUp = glm::vec3(upX, upY, upZ);
+        WorldUp = glm::normalize(glm::vec3(upX, upY, upZ));
         Yaw = yaw;
         Pitch = pitch;
         updateCameraVectors();
     }
     
-    // Returns the view matrix calculated using Euler Angles and the LookAt Matrix
-    glm::mat4 GetViewMatrix()
+    // Returns the view matrix, the same as glm::lookAt(Position, Position + Front, Up)
+    const glm::mat4& GetViewMatrix() const
+    {
+        if (dirty & VIEW_DIRTY)
+        {
+            // the inverse rotation is the conjugate, applied after moving the eye to the origin
+            glm::mat3 rotation = glm::mat3_cast(glm::conjugate(Orientation));
+            view = glm::mat4(rotation);
+            view[3] = glm::vec4(-(rotation * Position), 1.0f);
+            inverseView = glm::mat4(glm::mat3_cast(Orientation));
+            inverseView[3] = glm::vec4(Position, 1.0f);
+            dirty = (dirty & ~VIEW_DIRTY) | VIEW_PROJECTION_DIRTY;
+        }
+        return view;
+    }
+    
+    const glm::mat4& GetProjectionMatrix() const
+    {
+        if (dirty & PROJECTION_DIRTY)
+        {
+            projection = BuildProjection(Zoom, Aspect, Near, Far, Depth);
+            inverseProjection = glm::inverse(projection);
+            dirty = (dirty & ~PROJECTION_DIRTY) | VIEW_PROJECTION_DIRTY;
+        }
+        return projection;
+    }
+    
+    const glm::mat4& GetViewProjectionMatrix() const
+    {
+        GetViewMatrix();
+        GetProjectionMatrix();
+        if (dirty & VIEW_PROJECTION_DIRTY)
+        {
+            viewProjection = projection * view;
+            inverseViewProjection = inverseView * inverseProjection;
+            dirty &= ~VIEW_PROJECTION_DIRTY;
+        }
+        return viewProjection;
+    }
+    
+    const glm::mat4& GetInverseViewMatrix() const { GetViewMatrix(); return inverseView; }
+    const glm::mat4& GetInverseProjectionMatrix() const { GetProjectionMatrix(); return inverseProjection; }
+    const glm::mat4& GetInverseViewProjectionMatrix() const { GetViewProjectionMatrix(); return inverseViewProjection; }
+    
+    // A point in normalised device coordinates back in world space, e.g. the cursor for picking;
+    // x and y are -1..1, z is -1..1 in DEPTH_STANDARD and 1 (near) to 0 (infinity) in DEPTH_REVERSED
+    glm::vec3 Unproject(const glm::vec3 &ndc) const
+    {
+        glm::vec4 world = GetInverseViewProjectionMatrix() * glm::vec4(ndc, 1.0f);
+        return glm::vec3(world) / world.w;
+    }
+    
+    void SetProjection(float aspect, float nearPlane, float farPlane)
     {
-        return glm::lookAt(Position, Position + Front, Up);
+        Aspect = aspect;
+        Near = nearPlane;
+        Far = farPlane;
+        dirty |= PROJECTION_DIRTY;
+    }
+    
+    void SetDepthMode(DepthMode mode)
+    {
+        Depth = mode;
+        dirty |= PROJECTION_DIRTY;
+    }
+    
+    // the projection for either depth mode; zoom is the vertical field of view in degrees
+    static glm::mat4 BuildProjection(float zoom, float aspect, float nearPlane, float farPlane, DepthMode mode)
+    {
+        if (mode == DEPTH_STANDARD)
+            return glm::perspective(glm::radians(zoom), aspect, nearPlane, farPlane);
+        // clip z is the constant near plane and w the distance, so depth = near / distance
+        float scale = 1.0f / std::tan(glm::radians(zoom) * 0.5f);
+        glm::mat4 projection(0.0f);
+        projection[0][0] = scale / aspect;
+        projection[1][1] = scale;
+        projection[2][3] = -1.0f;
+        projection[3][2] = nearPlane;
+        return projection;
+    }
+    
+    void SetPosition(const glm::vec3 &position)
+    {
+        Position = position;
+        dirty |= VIEW_DIRTY;
+    }
+    
+    // places the camera outright, e.g. from a recorded path; the angles are in degrees and not clamped
+    void SetPose(const glm::vec3 &position, float yaw, float pitch, float zoom)
+    {
+        Position = position;
+        Yaw = yaw;
+        Pitch = pitch;
+        Zoom = zoom;
+        updateCameraVectors();
+        dirty |= PROJECTION_DIRTY;
     }
     
     // Processes input received from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM (to abstract it from windowing systems)
@@ -87,6 +198,7 @@ public:
             Position -= Right * velocity;
         if (direction == RIGHT)
             Position += Right * velocity;
+        dirty |= VIEW_DIRTY;
     }
     
     // Processes input received from a mouse input system. Expects the offset value in both the x and y direction.
@@ -107,7 +219,7 @@ public:
                 Pitch = -89.0f;
         }
         
-        // Update Front, Right and Up Vectors using the updated Euler angles
+        // Update the orientation and the Front, Right and Up Vectors from the updated Euler angles
         updateCameraVectors();
     }
     
@@ -120,21 +232,38 @@ public:
             Zoom = 1.0f;
         if (Zoom >= 45.0f)
             Zoom = 45.0f;
+        dirty |= PROJECTION_DIRTY;
     }
     
 private:
-    // Calculates the front vector from the Camera's (updated) Euler Angles
+    enum {
+        VIEW_DIRTY = 1,
+        PROJECTION_DIRTY = 2,
+        VIEW_PROJECTION_DIRTY = 4
+    };
+    
+    // caches, rebuilt on demand from the const getters
+    mutable unsigned int dirty = VIEW_DIRTY | PROJECTION_DIRTY | VIEW_PROJECTION_DIRTY;
+    mutable glm::mat4 view;
+    mutable glm::mat4 inverseView;
+    mutable glm::mat4 projection;
+    mutable glm::mat4 inverseProjection;
+    mutable glm::mat4 viewProjection;
+    mutable glm::mat4 inverseViewProjection;
+    
+    // Builds the orientation from the Euler angles: yaw around WorldUp, then pitch around the camera's own x axis.
+    // At Yaw -90 the camera looks down -z, as the Euler version did. The basis vectors come out unit length and
+    // orthogonal, no normalising or cross products needed.
     void updateCameraVectors()
     {
-        // Calculate the new Front vector
-        glm::vec3 front;
-        front.x = cos(glm::radians(Yaw)) * cos(glm::radians(Pitch));
-        front.y = sin(glm::radians(Pitch));
-        front.z = sin(glm::radians(Yaw)) * cos(glm::radians(Pitch));
-        Front = glm::normalize(front);
-        // Also re-calculate the Right and Up vector
-        Right = glm::normalize(glm::cross(Front, WorldUp));  // Normalize the vectors, because their length gets closer to 0 the more you look up or down which results in slower movement.
-        Up    = glm::normalize(glm::cross(Right, Front));
+        glm::quat yaw = glm::angleAxis(glm::radians(-90.0f - Yaw), WorldUp);
+        glm::quat pitch = glm::angleAxis(glm::radians(Pitch), glm::vec3(1.0f, 0.0f, 0.0f));
+        Orientation = yaw * pitch;
+        glm::mat3 basis = glm::mat3_cast(Orientation);
+        Right = basis[0];
+        Up    = basis[1];
+        Front = -basis[2];
+        dirty |= VIEW_DIRTY;
     }
 };
 #endif
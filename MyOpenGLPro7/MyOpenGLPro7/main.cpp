@@ -1,4 +1,6 @@
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
 #include <math3d.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -9,16 +11,96 @@
 #include "glm/glm/gtc/matrix_transform.hpp"
 #include "glm/glm/gtc/type_ptr.hpp"
 #include "headers/camera.h"
+#include "headers/GLExtensions.h"
+#include "headers/FrameConstants.h"
+#include "headers/ProgramCache.h"
+#include "headers/ShaderCompiler.h"
+#include "headers/ShaderVariants.h"
+#include "headers/ShaderReloader.h"
+#include "headers/GLStateCache.h"
+#include "headers/IndirectDrawBuilder.h"
+#include "headers/RenderQueue.h"
+#include "headers/MeshBuilder.h"
+#include "headers/VertexFormat.h"
+#include "headers/CubeTransforms.h"
+#include "headers/JobSystem.h"
+#include "headers/Frustum.h"
+#include "headers/SceneBVH.h"
+#include "headers/Simulation.h"
+#include "headers/FramePacer.h"
+#include "headers/SceneTarget.h"
 
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 
-// camera
-Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+// the cube as 36 expanded corners: position, uv
+const float vertices[] = {
+    -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
+    0.5f, -0.5f, -0.5f,  1.0f, 0.0f,
+    0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
+    0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
+    
+    -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
+    0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
+    0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
+    0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
+    
+    -0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
+    
+    0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
+    0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
+    0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
+    0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
+    0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
+    0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
+    
+    -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
+    0.5f, -0.5f, -0.5f,  1.0f, 1.0f,
+    0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
+    0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
+    
+    -0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
+    0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
+    0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
+    0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f, 1.0f
+};
+
+// used to give positions of different cudes in world coordinate system
+const glm::vec3 cubePositions[] = {
+    glm::vec3( 0.0f,  0.0f,  0.0f),
+    glm::vec3( 2.0f,  5.0f, -15.0f),
+    glm::vec3(-1.5f, -2.2f, -2.5f),
+    glm::vec3(-3.8f, -2.0f, -12.3f),
+    glm::vec3( 2.4f, -0.4f, -3.5f),
+    glm::vec3(-1.7f,  3.0f, -7.5f),
+    glm::vec3( 1.3f, -2.0f, -2.5f),
+    glm::vec3( 1.5f,  2.0f, -2.5f),
+    glm::vec3( 1.5f,  0.2f, -1.5f),
+    glm::vec3(-1.3f,  1.0f, -1.5f)
+};
+
+// where every session starts, live or replayed
+const glm::vec3 CAMERA_START(0.0f, 0.0f, 3.0f);
+// camera, moved by the simulation thread
+Camera camera(CAMERA_START);
 float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
-float lastFrame = 0, deltaTime = 0;
+// the simulation's input queue, fed by the callbacks on the main thread
+InputQueue *inputQueue = NULL;
 
 // framebuffer_size_callback is a callback function to adjust to the resizing
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -27,15 +109,52 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 
 // handle scroll move
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+// a left click picks the cube under the crosshair
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+// WASD presses and releases move the camera
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 
 // when escape is pressed
 // we tell glfw the window should close
 void processInput(GLFWwindow *window);
 // process WASD keys to allow users to move the camera
 void processWASD(GLFWwindow *window, const glm::vec3 &cameraUp, const glm::vec3 &cameraFront, glm::vec3 &cameraPos, float renderTimePerFrame);
+// the spinning cubes and the BVH over them
+void buildCubeScene(CubeTransforms &transforms, SceneBVH &bvh);
+// run a recorded session without a window, as fast as possible
+int replaySession(const char *path);
 
 
 int main(int argc,char * argv[]) {
+    // --record <file> saves the input of every simulation step, --replay <file> plays it back headless,
+    // --fps <n> holds the frame rate at n, --record-path <file> saves the camera's flight,
+    // --fly <file> flies it again without input and quits at its end, --headless hides the window and vsync for that
+    const char *recordPath = NULL;
+    const char *cameraPathFile = NULL;
+    const char *flyPath = NULL;
+    bool headless = false;
+    double targetFps = 0.0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--headless") == 0)
+            headless = true;
+        if (i + 1 == argc)
+            break;
+        if (strcmp(argv[i], "--replay") == 0)
+            return replaySession(argv[i + 1]);
+        if (strcmp(argv[i], "--record") == 0)
+            recordPath = argv[i + 1];
+        if (strcmp(argv[i], "--record-path") == 0)
+            cameraPathFile = argv[i + 1];
+        if (strcmp(argv[i], "--fly") == 0)
+            flyPath = argv[i + 1];
+        if (strcmp(argv[i], "--fps") == 0)
+            targetFps = atof(argv[i + 1]);
+    }
+    CameraPath flight;
+    if (flyPath && !flight.load(flyPath))
+        return -1;
+    
     //tell glfw how to configure the window we want to build
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -45,6 +164,9 @@ int main(int argc,char * argv[]) {
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+    // an offscreen run still renders every frame, nobody has to watch it
+    if (flyPath && headless)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
     
     // create a window
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
@@ -67,6 +189,8 @@ int main(int argc,char * argv[]) {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    // entry points newer than GL 3.3, NULL where the driver lacks them
+    loadGLExtensions((GLADloadproc)glfwGetProcAddress);
     
     // tell opengl how to render the window
     // first two specify the location
@@ -78,75 +202,58 @@ int main(int argc,char * argv[]) {
     //We register the callback functions after we've created the window and before the game loop is initiated.
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
+    glfwSetKeyCallback(window, key_callback);
     // link the pipeline
     // in order to read file in xcode
     // check Product->Scheme->Edit Scheme->Options->Working Directory: Using custom working directory
     // and specify the path with main.cpp's path
-    Shader ourShader("vshader.vs", "fshader.fs");
-    
-    
-    float vertices[] = {
-        -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
-        0.5f, -0.5f, -0.5f,  1.0f, 0.0f,
-        0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-        0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
-        
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-        0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-        0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
-        0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
-        -0.5f,  0.5f,  0.5f,  0.0f, 1.0f,
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-        
-        -0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-        -0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-        -0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-        
-        0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-        0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-        0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-        0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-        0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-        0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-        
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-        0.5f, -0.5f, -0.5f,  1.0f, 1.0f,
-        0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-        0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-        
-        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
-        0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-        0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-        0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-        -0.5f,  0.5f,  0.5f,  0.0f, 0.0f,
-        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f
-    };
-    
+    // linked programs are cached on disk, later launches skip compile and link
+    ProgramCache programCache("shadercache");
+    // only queue the compile here, the textures below are decoded while the driver works
+    ShaderCompiler shaderCompiler(&programCache);
+    // one source pair, specialised per set of #defines; identical variants share a program
+    // edits to the shader files are picked up while running
+    ShaderReloader shaderReloader(&programCache);
+    ShaderVariants shaderVariants(shaderCompiler, &shaderReloader);
+    // INSTANCED reads the model matrix per instance, for the render queue
+    ShaderHandle ourShaderHandle = shaderVariants.request("vshader.vs", "fshader.fs", ShaderDefines().set("INSTANCED").set("USE_TINT").set("SAMPLER_COUNT", "2"));
+    
+    
+    // weld the 36 expanded corners into shared vertices + 16 bit indices in cache-friendly order
+    MeshBuilder cubeMesh(5);
+    cubeMesh.build(vertices, sizeof(vertices) / (sizeof(float) * 5));
+    cubeMesh.report("cube");
+    // half-float positions and normalised 16 bit UVs: 12 bytes per vertex instead of 20
+    VertexFormat cubeFormat;
+    cubeFormat.add(0, 3, VERTEX_HALF).add(1, 2, VERTEX_UNORM16);
+    std::vector<unsigned char> cubeVertices = cubeFormat.pack(&cubeMesh.vertices()[0], cubeMesh.vertexCount());
+    // static meshes of one format share a vertex and an index buffer, so their draws can be merged into multi-draws
+    IndirectDrawBuilder staticMeshes(cubeFormat.stride());
+    MeshRange cubeRange = staticMeshes.addMesh(&cubeVertices[0], cubeMesh.vertexCount(), &cubeMesh.indices()[0], cubeMesh.indexCount());
     
     // gen VAO & VBO & EBO and configure them
-    unsigned int VAO, VBO;
+    unsigned int VAO, VBO, EBO;
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
     
-    glBindVertexArray(VAO);
+    glState().bindVertexArray(VAO);
     
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, staticMeshes.vertexData().size(), &staticMeshes.vertexData()[0], GL_STATIC_DRAW);
     // Note: EBO should be bound to GL_ELEMENT_ARRAY_BUFFER not simple GL_ARRAY_BUFFER
+    glState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, staticMeshes.indexData().size() * sizeof(GLushort), &staticMeshes.indexData()[0], GL_STATIC_DRAW);
 
     
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (void*)0);
-    glEnableVertexAttribArray(0);
+    // attribute pointers come from the format, so they always match the packing
+    cubeFormat.apply();
     
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (void*)(sizeof(float)*3));
-    glEnableVertexAttribArray(1);
+    // draws are sorted by state and runs with the same state become one instanced draw;
+    // per-instance model matrices go into the queue's own buffer on the same VAO
+    RenderQueue renderQueue;
+    uint32_t cubeDrawMesh = renderQueue.addMesh(VAO, cubeRange);
     
     // unbind vbo and vao
     // bind vao when needed
@@ -154,7 +261,7 @@ int main(int argc,char * argv[]) {
     //    glBindVertexArray(0);
     
     // set wireframe/fillframe
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glState().polygonMode(GL_FILL);
     
     // set texture
     
@@ -162,7 +269,7 @@ int main(int argc,char * argv[]) {
     glGenTextures(1, &tex1);
     
     // bind
-    glBindTexture(GL_TEXTURE_2D, tex1);
+    glState().bindTexture(0, GL_TEXTURE_2D, tex1);
     // set texture wrap and texture filter
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -180,11 +287,11 @@ int main(int argc,char * argv[]) {
         std::cout << "Failed to load texture" << std::endl;
     }
     stbi_image_free(data1);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    glState().bindTexture(0, GL_TEXTURE_2D, 0);
     
     glGenTextures(1, &tex2);
     // bind
-    glBindTexture(GL_TEXTURE_2D, tex2);
+    glState().bindTexture(0, GL_TEXTURE_2D, tex2);
     // set texture wrap and texture filter
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -201,56 +308,107 @@ int main(int argc,char * argv[]) {
         std::cout << "Failed to load texture" << std::endl;
     }
     stbi_image_free(data2);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    glState().bindTexture(0, GL_TEXTURE_2D, 0);
+    GLuint cubeTextures[] = { tex1, tex2 };
+    uint32_t cubeTextureSet = renderQueue.addTextureSet(cubeTextures, 2);
 
+    // first point that needs the program, finish compiling it and anything else still queued
+    shaderCompiler.finishAll();
+    Shader &ourShader = ourShaderHandle.get();
+    if (ourShader.loadError().status != SOURCE_OK)
+    {
+        std::cout << "Failed to load shader: " << ourShader.loadError().describe() << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    // camera matrices are shared by all programs through the PerFrame uniform block
+    FrameConstants frameConstants;
+    frameConstants.attach(ourShader);
+    
     // set texture unit (location) to uniform vars
     ourShader.use();
     ourShader.setInt("texture1", 0);
     ourShader.setInt("texture2", 1);
     
-    // activate and bind
-    // when activating the texture
-    // use the GL_Texture0/1/... instead of 0/1/...
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, tex1);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, tex2);
-    
-
+    // resolve uniform handles once, the render loop only sets them
+    Uniform<glm::vec2> ourGBUniform = ourShader.getUniform<glm::vec2>("ourGB");
     
     
-    // used to give positions of different cudes in world coordinate system
-    glm::vec3 cubePositions[] = {
-        glm::vec3( 0.0f,  0.0f,  0.0f),
-        glm::vec3( 2.0f,  5.0f, -15.0f),
-        glm::vec3(-1.5f, -2.2f, -2.5f),
-        glm::vec3(-3.8f, -2.0f, -12.3f),
-        glm::vec3( 2.4f, -0.4f, -3.5f),
-        glm::vec3(-1.7f,  3.0f, -7.5f),
-        glm::vec3( 1.3f, -2.0f, -2.5f),
-        glm::vec3( 1.5f,  2.0f, -2.5f),
-        glm::vec3( 1.5f,  0.2f, -1.5f),
-        glm::vec3(-1.3f,  1.0f, -1.5f)
-    };
+    // cube transforms are computed on all cores; the render thread only uploads them
+    JobSystem jobSystem;
+    CubeTransforms cubeTransforms;
+    SceneBVH sceneBVH;
+    buildCubeScene(cubeTransforms, sceneBVH);
+    // picking tests the exact triangles
+    BVHMesh cubeTriangles(&cubeMesh.vertices()[0], cubeMesh.vertexCount(), 5, cubeMesh.indices());
     
+    // reverse-Z with an infinite far plane where the clip depth range can be 0..1, the usual -1..1 setup otherwise;
+    // the scene is then drawn into float depth offscreen, on the window's fixed point depth only the far plane would go
+    SceneTarget sceneTarget;
+    bool offscreen = false;
+    int framebufferWidth = SCR_WIDTH, framebufferHeight = SCR_HEIGHT;
+    if (glExt().hasClipControl())
+    {
+        glExt().ClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+        glClearDepth(0.0);
+        glState().depthFunc(GL_GREATER);
+        camera.SetDepthMode(Camera::DEPTH_REVERSED);
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        offscreen = sceneTarget.resize(framebufferWidth, framebufferHeight);
+    }
     
+    // from here on camera, cube transforms and BVH belong to the simulation thread;
+    // this thread samples input and renders the snapshots it publishes
+    Simulation simulation(camera, cubeTransforms, sceneBVH, cubeTriangles, jobSystem, (float)SCR_WIDTH / (float)SCR_HEIGHT);
+    InputRecording recording;
+    if (recordPath)
+        simulation.record(&recording);
+    CameraPath cameraPath;
+    if (cameraPathFile)
+        simulation.recordPath(&cameraPath);
+    if (flyPath)
+        simulation.follow(&flight);
+    inputQueue = &simulation.input();
+    simulation.start();
     
     // enable depth test
-    glEnable(GL_DEPTH_TEST);
+    glState().enable(GL_DEPTH_TEST);
     
-    // used to compute the time spent on rendering each frame
-
+    // vsync that tears rather than dropping to half rate when late, and at most two frames
+    // queued ahead of the GPU so what is on screen is never far behind the input
+    FramePacer framePacer(2);
+    framePacer.setSwapMode(flyPath && headless ? FramePacer::SWAP_IMMEDIATE : FramePacer::SWAP_ADAPTIVE);
+    framePacer.setTargetFps(targetFps);
+    
+    uint64_t flightFrames = 0;
+    double flightStart = 0.0;
     
     // render loop
     while(!glfwWindowShouldClose(window))
     {
-        float currentTime = (float)glfwGetTime();
-        deltaTime = currentTime - lastFrame;
-        lastFrame = currentTime;
+        // wait for the GPU and the frame deadline first, so the input below is as fresh as possible
+        framePacer.beginFrame();
+        // check the events happen in this iteration
+        // updates the window state, and calls the corresponding functions
+        glfwPollEvents();
         // INPUT processing
         processInput(window);
+        // the mouse motion of all events above goes out as one event
+        inputQueue->flush();
+        // swap in shaders that were edited and rebuilt since the last frame
+        shaderReloader.update();
         
         //RENDER HERE
+        // follow the window's size; draw straight to it while minimised, and for good if the target breaks
+        bool drawOffscreen = false;
+        if (offscreen)
+        {
+            glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+            if (framebufferWidth > 0 && framebufferHeight > 0)
+                offscreen = drawOffscreen = sceneTarget.resize(framebufferWidth, framebufferHeight);
+            if (drawOffscreen)
+                sceneTarget.bind();
+        }
         // tell glClear to clear the color buffer in last iteration with RGBA specified here
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);// clear the color buffer and z-buffer
@@ -263,8 +421,7 @@ int main(int argc,char * argv[]) {
         
         
         
-        ourShader.setVec2("ourGB", ourGreen, ourBlue);
-        glBindVertexArray(VAO); // seeing as we only have a single VAO there's no need to bind it every time, but we'll do so to keep things a bit more organized
+        ourShader.set(ourGBUniform, glm::vec2(ourGreen, ourBlue));
         
 //        float radius = 10.0f;
 //        float camX = sin(glfwGetTime()) * radius;
@@ -273,41 +430,110 @@ int main(int argc,char * argv[]) {
 //        view = glm::lookAt(glm::vec3(camX, 0.0, camZ), glm::vec3(0.0, 0.0, 0.0), glm::vec3(0.0, 1.0, 0.0));
 //        ourShader.setGlmValueMat4("view", glm::value_ptr(view));
         
-        glm::mat4 view = camera.GetViewMatrix();
-        ourShader.setGlmValueMat4("view", glm::value_ptr(view));
-        
-        glm::mat4 project = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        ourShader.setGlmValueMat4("project", glm::value_ptr(project));
+        // the newest state the simulation published, culled and animated already;
+        // blended between its last two steps so motion stays smooth at any frame rate
+        const FrameSnapshot &frame = simulation.latestFrame();
+        float alpha = simulation.blend(frame);
+        CameraState eye = frame.cameraAt(alpha);
+        // a fly-through ends with its path; everything from its first frame counts
+        if (flyPath && frame.time >= flight.duration())
+            glfwSetWindowShouldClose(window, true);
+        if (flyPath && flightFrames++ == 0)
+            flightStart = glfwGetTime();
+        frameConstants.update(eye.view(), eye.project((float)SCR_WIDTH / (float)SCR_HEIGHT), eye.position, frame.timeAt(alpha));
         
-        for(unsigned int i = 0; i < 10; i++)
+        // submitted one by one, front to back; the queue merges them into one instanced draw
+        for(size_t i = 0; i < frame.models.size(); i++)
         {
-            // let all 10 cubes rotate
-            glm::mat4 model;
-            model = glm::translate(model, cubePositions[i]);
-            float angle = 20.0f * i;
-            model = glm::rotate(model, (float)glfwGetTime()/10* glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-            ourShader.setGlmValueMat4("model", glm::value_ptr(model));
-            
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            glm::mat4 model = frame.modelAt(i, alpha);
+            float depth = glm::dot(glm::vec3(model[3]) - eye.position, eye.front);
+            renderQueue.submit(RenderQueue::PASS_OPAQUE, ourShader.ID, cubeTextureSet, cubeDrawMesh, depth, model);
         }
+        renderQueue.flush();
 //        glDrawArrays(GL_TRIANGLES, 0, 36);
+        renderQueue.endFrame();
+        frameConstants.endFrame();
+        if (drawOffscreen)
+            sceneTarget.present();
+        framePacer.endFrame();
         
         
         // SHOW
         // swap the render buffer to the screen buffer every iteration
         glfwSwapBuffers(window);
-        // check the events happen in this iteration
-        // updates the window state, and calls the corresponding functions
-        glfwPollEvents();
     }
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+    simulation.stop();
+    if (recordPath && recording.save(recordPath, Simulation::STEP_RATE))
+        std::cout << "SIM::RECORD " << recording.size() << " steps to " << recordPath << std::endl;
+    if (cameraPathFile && cameraPath.save(cameraPathFile))
+        std::cout << "CAMERA_PATH::RECORD " << cameraPath.size() << " keys, " << cameraPath.duration() << " s to " << cameraPathFile << std::endl;
+    if (flyPath && flightFrames > 0)
+    {
+        double flightSeconds = glfwGetTime() - flightStart;
+        std::cout << "CAMERA_PATH::FLY " << flightFrames << " frames in " << flightSeconds << " s, "
+                  << flightSeconds * 1000.0 / flightFrames << " ms per frame" << std::endl;
+    }
+    const RenderQueue::Stats &queueStats = renderQueue.stats();
+    std::cout << "RENDER::QUEUE last frame " << queueStats.draws << " draws in " << queueStats.drawCalls << " calls ("
+              << queueStats.indirectCommands << " indirect commands), "
+              << queueStats.programChanges << " program / " << queueStats.textureChanges << " texture / "
+              << queueStats.vertexArrayChanges << " vertex array changes" << std::endl;
+    framePacer.report();
+    framePacer.release();
+    renderQueue.release();
+    glState().deleteVertexArray(VAO);
+    glState().deleteBuffer(VBO);
+    glState().deleteBuffer(EBO);
+    frameConstants.release();
+    sceneTarget.release();
+    const GLStateCache::Stats &stateStats = glState().stats();
+    std::cout << "GL::STATE issued " << stateStats.totalIssued() << " elided " << stateStats.totalElided() << std::endl;
     // release the resources occupied by glfw
     glfwTerminate();
     return 0;
 }
 
 
+void buildCubeScene(CubeTransforms &transforms, SceneBVH &bvh)
+{
+    for(unsigned int i = 0; i < 10; i++)
+    {
+        // let all 10 cubes rotate, the same speeds as before
+        float angle = 20.0f * i;
+        transforms.add(cubePositions[i], glm::radians(angle) / 10);
+    }
+    // boxes around the bounding spheres stay valid however the cubes turn,
+    // so the tree is built once; only picking needs the exact current matrices
+    for(unsigned int i = 0; i < 10; i++)
+        bvh.add(cubePositions[i] - glm::vec3(transforms.boundingRadii()[i]), cubePositions[i] + glm::vec3(transforms.boundingRadii()[i]));
+    bvh.build();
+}
+
+int replaySession(const char *path)
+{
+    InputRecording recording;
+    if (!recording.load(path, Simulation::STEP_RATE))
+        return -1;
+    MeshBuilder cubeMesh(5);
+    cubeMesh.build(vertices, sizeof(vertices) / (sizeof(float) * 5));
+    BVHMesh cubeTriangles(&cubeMesh.vertices()[0], cubeMesh.vertexCount(), 5, cubeMesh.indices());
+    JobSystem jobSystem;
+    CubeTransforms cubeTransforms;
+    SceneBVH sceneBVH;
+    buildCubeScene(cubeTransforms, sceneBVH);
+    Camera replayCamera(CAMERA_START);
+    // no context here, so the live run's depth mode comes from the recording
+    if (recording.reversedDepth())
+        replayCamera.SetDepthMode(Camera::DEPTH_REVERSED);
+    Simulation simulation(replayCamera, cubeTransforms, sceneBVH, cubeTriangles, jobSystem, (float)SCR_WIDTH / (float)SCR_HEIGHT);
+    double seconds = simulation.replay(recording);
+    // the final camera position tells at a glance whether two replays agree
+    std::cout << "SIM::REPLAY " << recording.size() << " steps in " << seconds << " s ("
+              << (seconds > 0.0 ? recording.size() / seconds : 0.0) << " steps/s), camera at "
+              << replayCamera.Position.x << " " << replayCamera.Position.y << " " << replayCamera.Position.z << std::endl;
+    return 0;
+}
+
 // framebuffer_size_callback is a callback function to adjust to the resizing
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
@@ -328,9 +554,8 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
     lastX = xpos;
     lastY = ypos;
     
-    camera.ProcessMouseMovement(xoffset, yoffset);
-
-    
+    if (inputQueue)
+        inputQueue->look(xoffset, yoffset);
 }
 
 // when escape is pressed
@@ -339,19 +564,25 @@ void processInput(GLFWwindow *window)
 {
     if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-        camera.ProcessKeyboard(FORWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-        camera.ProcessKeyboard(BACKWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-        camera.ProcessKeyboard(LEFT, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-        camera.ProcessKeyboard(RIGHT, deltaTime);
-        
 }
 
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset){
     // limit the fov between 1 and 45 degrees
-    camera.ProcessMouseScroll(yoffset);
+    if (inputQueue)
+        inputQueue->scroll(yoffset);
+}
+
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods){
+    if (inputQueue && button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+        inputQueue->pick();
+}
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods){
+    // only presses and releases; the simulation moves the camera by its own time step while a key is held
+    if (!inputQueue || action == GLFW_REPEAT)
+        return;
+    int move = key == GLFW_KEY_W ? FORWARD : key == GLFW_KEY_S ? BACKWARD : key == GLFW_KEY_A ? LEFT : key == GLFW_KEY_D ? RIGHT : -1;
+    if (move >= 0)
+        inputQueue->key(move, action == GLFW_PRESS);
 }
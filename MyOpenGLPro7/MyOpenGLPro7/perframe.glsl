@@ -0,0 +1,9 @@
+// shared by every program, uploaded once per frame by FrameConstants
+layout (std140) uniform PerFrame
+{
+    mat4 view;
+    mat4 project;
+    mat4 viewProject;
+    vec3 cameraPos;
+    float time;
+};
@@ -0,0 +1,84 @@
+//
+//  CameraArrayTest.cpp
+//  MyOpenGLPro7
+//
+//  CameraArray::update() against Camera for eleven cameras, so with SSE two
+//  groups of four go through computeFour and the last three through the
+//  scalar tail; every lane must give the same view, projection,
+//  view-projection and frustum as the Camera it was added from. Needs no GL.
+//    c++ -std=gnu++14 -I<glad>/include tests/CameraArrayTest.cpp -o CameraArrayTest
+//
+
+#include "TestCheck.h"
+#include "../headers/CameraArray.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+static const int CAMERAS = 11;
+
+static bool near(float a, float b, float tolerance)
+{
+    return std::fabs(a - b) <= tolerance * std::fmax(1.0f, std::fabs(b));
+}
+
+static bool sameMatrix(const glm::mat4 &a, const glm::mat4 &b, float tolerance)
+{
+    for (int c = 0; c < 4; c++)
+        for (int r = 0; r < 4; r++)
+            if (!near(a[c][r], b[c][r], tolerance))
+                return false;
+    return true;
+}
+
+static bool sameFrustum(const Frustum &a, const Frustum &b, float tolerance)
+{
+    for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+        for (int k = 0; k < 4; k++)
+            if (!near(a.planes[p][k], b.planes[p][k], tolerance))
+                return false;
+    return true;
+}
+
+int main()
+{
+    // every camera different in pose and projection, so a lane mix-up shows
+    std::vector<Camera> cameras;
+    CameraArray array;
+    for (int i = 0; i < CAMERAS; i++)
+    {
+        Camera camera(glm::vec3(i * 1.5f - 7.0f, std::sin((float)i) * 4.0f, 10.0f - i), glm::vec3(0.0f, 1.0f, 0.0f),
+                      -90.0f + i * 33.0f, -40.0f + i * 8.0f);
+        camera.Zoom = 30.0f + i * 1.5f;
+        camera.SetProjection(1.0f + i * 0.1f, 0.1f + i * 0.05f, 50.0f + i * 10.0f);
+        cameras.push_back(camera);
+        array.add(camera);
+    }
+    array.update();
+    check(array.size() == CAMERAS, "every camera added");
+
+    char what[64];
+    for (int i = 0; i < CAMERAS; i++)
+    {
+        const Camera &camera = cameras[i];
+        snprintf(what, sizeof(what), "camera %d view", i);
+        check(sameMatrix(array.view(i), camera.GetViewMatrix(), 1e-5f), what);
+        snprintf(what, sizeof(what), "camera %d projection", i);
+        check(sameMatrix(array.projection(i), camera.GetProjectionMatrix(), 1e-5f), what);
+        snprintf(what, sizeof(what), "camera %d view-projection", i);
+        check(sameMatrix(array.viewProjection(i), camera.GetViewProjectionMatrix(), 1e-4f), what);
+        snprintf(what, sizeof(what), "camera %d frustum", i);
+        check(sameFrustum(array.frustum(i), Frustum::fromMatrix(camera.GetViewProjectionMatrix()), 1e-4f), what);
+    }
+
+    // moving one camera changes only its own lane
+    cameras[5].SetPose(glm::vec3(3.0f, 2.0f, 1.0f), 10.0f, 20.0f, cameras[5].Zoom);
+    array.set(5, cameras[5]);
+    array.update();
+    check(sameMatrix(array.view(5), cameras[5].GetViewMatrix(), 1e-5f), "moved camera follows");
+    check(sameMatrix(array.view(4), cameras[4].GetViewMatrix(), 1e-5f) && sameMatrix(array.view(6), cameras[6].GetViewMatrix(), 1e-5f),
+          "neighbouring lanes unchanged");
+
+    return checkResult("camera array");
+}
@@ -0,0 +1,401 @@
+//
+//  GLRecorder.h
+//  MyOpenGLPro7
+//
+//  A stand-in for the driver for the programs in tests/ and benchmarks/:
+//  installGLRecorder() points glad's entry points (and glExt()'s) at stubs
+//  that count every call by name and keep just enough state for the code
+//  under test to run without a context: buffer contents for mapping, program
+//  binaries, link status and a list of active uniforms.
+//
+
+#ifndef GL_RECORDER_H
+#define GL_RECORDER_H
+
+#include <glad/glad.h>
+#include "../headers/GLExtensions.h"
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+struct GLRecorder
+{
+    struct ActiveUniform
+    {
+        std::string name;
+        GLenum type;
+        GLint size;
+    };
+
+    // reported by glGetProgramiv / glGetActiveUniform for every program, location = index
+    std::vector<ActiveUniform> uniforms;
+    // what glGetProgramBinary hands out, and what glProgramBinary last received
+    std::vector<char> programBinary;
+    GLenum binaryFormat = 1;
+    std::vector<char> loadedBinary;
+    // glProgramBinary links only if the driver accepts it
+    bool acceptBinary = true;
+    GLint binaryFormats = 1;
+    std::string renderer = "GLRecorder";
+
+    // buffer contents by name, and what is bound to each target
+    std::map<GLuint, std::vector<char> > buffers;
+    std::map<GLenum, GLuint> boundBuffers;
+    std::map<GLuint, GLint> linkStatus;
+    GLuint currentProgram = 0;
+    GLuint nextName = 1;
+    // instances asked for by all draws, instanced and indirect
+    unsigned long long instancesDrawn = 0;
+    // bytes handed to buffers: glBufferData with data, glBufferSubData and every glMapBufferRange length
+    unsigned long long bytesUploaded = 0;
+
+    // calls of the named entry point since the last reset()
+    unsigned calls(const char *name) const
+    {
+        std::map<std::string, unsigned>::const_iterator it = counters.find(name);
+        return it == counters.end() ? 0 : it->second;
+    }
+
+    unsigned totalCalls() const
+    {
+        unsigned total = 0;
+        for (std::map<std::string, unsigned>::const_iterator it = counters.begin(); it != counters.end(); ++it)
+            total += it->second;
+        return total;
+    }
+
+    // zero the counters, keeping the simulated objects
+    void reset()
+    {
+        for (std::map<std::string, unsigned>::iterator it = counters.begin(); it != counters.end(); ++it)
+            it->second = 0;
+        instancesDrawn = 0;
+        bytesUploaded = 0;
+    }
+
+    // the stubs keep a reference to their counter, which a std::map never moves
+    unsigned& counter(const char *name) { return counters[name]; }
+
+    std::vector<char>* bound(GLenum target)
+    {
+        std::map<GLenum, GLuint>::iterator it = boundBuffers.find(target);
+        return it == boundBuffers.end() || it->second == 0 ? NULL : &buffers[it->second];
+    }
+
+private:
+    std::map<std::string, unsigned> counters;
+};
+
+inline GLRecorder& glRecorder()
+{
+    static GLRecorder recorder;
+    return recorder;
+}
+
+namespace GLRecorderStubs {
+
+#define GL_RECORD(name) static unsigned &recorded = glRecorder().counter(name); recorded++
+
+// state
+inline void APIENTRY useProgram(GLuint program) { GL_RECORD("glUseProgram"); glRecorder().currentProgram = program; }
+inline void APIENTRY bindVertexArray(GLuint) { GL_RECORD("glBindVertexArray"); }
+inline void APIENTRY activeTexture(GLenum) { GL_RECORD("glActiveTexture"); }
+inline void APIENTRY bindTexture(GLenum, GLuint) { GL_RECORD("glBindTexture"); }
+inline void APIENTRY bindBuffer(GLenum target, GLuint buffer) { GL_RECORD("glBindBuffer"); glRecorder().boundBuffers[target] = buffer; }
+inline void APIENTRY bindBufferRange(GLenum target, GLuint, GLuint buffer, GLintptr, GLsizeiptr) { GL_RECORD("glBindBufferRange"); glRecorder().boundBuffers[target] = buffer; }
+inline void APIENTRY enable(GLenum) { GL_RECORD("glEnable"); }
+inline void APIENTRY disable(GLenum) { GL_RECORD("glDisable"); }
+inline void APIENTRY blendFunc(GLenum, GLenum) { GL_RECORD("glBlendFunc"); }
+inline void APIENTRY depthFunc(GLenum) { GL_RECORD("glDepthFunc"); }
+inline void APIENTRY depthMask(GLboolean) { GL_RECORD("glDepthMask"); }
+inline void APIENTRY polygonMode(GLenum, GLenum) { GL_RECORD("glPolygonMode"); }
+
+// objects
+inline void APIENTRY genBuffers(GLsizei n, GLuint *names)
+{
+    GL_RECORD("glGenBuffers");
+    for (GLsizei i = 0; i < n; i++)
+        names[i] = glRecorder().nextName++;
+}
+inline void APIENTRY deleteBuffers(GLsizei n, const GLuint *names)
+{
+    GL_RECORD("glDeleteBuffers");
+    for (GLsizei i = 0; i < n; i++)
+        glRecorder().buffers.erase(names[i]);
+}
+inline void APIENTRY deleteVertexArrays(GLsizei, const GLuint*) { GL_RECORD("glDeleteVertexArrays"); }
+inline void APIENTRY deleteTextures(GLsizei, const GLuint*) { GL_RECORD("glDeleteTextures"); }
+inline void APIENTRY deleteProgram(GLuint program) { GL_RECORD("glDeleteProgram"); glRecorder().linkStatus.erase(program); }
+
+// buffer data
+inline void APIENTRY bufferData(GLenum target, GLsizeiptr size, const void *data, GLenum)
+{
+    GL_RECORD("glBufferData");
+    if (data)
+        glRecorder().bytesUploaded += (unsigned long long)size;
+    std::vector<char> *buffer = glRecorder().bound(target);
+    if (!buffer)
+        return;
+    buffer->assign((size_t)size, 0);
+    if (data)
+        memcpy(&(*buffer)[0], data, (size_t)size);
+}
+inline void APIENTRY bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data)
+{
+    GL_RECORD("glBufferSubData");
+    glRecorder().bytesUploaded += (unsigned long long)size;
+    std::vector<char> *buffer = glRecorder().bound(target);
+    if (buffer && (size_t)(offset + size) <= buffer->size())
+        memcpy(&(*buffer)[offset], data, (size_t)size);
+}
+inline void* APIENTRY mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield)
+{
+    GL_RECORD("glMapBufferRange");
+    glRecorder().bytesUploaded += (unsigned long long)length;
+    std::vector<char> *buffer = glRecorder().bound(target);
+    return buffer && (size_t)(offset + length) <= buffer->size() ? &(*buffer)[offset] : NULL;
+}
+inline GLboolean APIENTRY unmapBuffer(GLenum) { GL_RECORD("glUnmapBuffer"); return GL_TRUE; }
+inline GLsync APIENTRY fenceSync(GLenum, GLbitfield) { GL_RECORD("glFenceSync"); return (GLsync)(size_t)glRecorder().nextName++; }
+inline GLenum APIENTRY clientWaitSync(GLsync, GLbitfield, GLuint64) { GL_RECORD("glClientWaitSync"); return GL_ALREADY_SIGNALED; }
+inline void APIENTRY deleteSync(GLsync) { GL_RECORD("glDeleteSync"); }
+
+// vertex input and draws
+inline void APIENTRY enableVertexAttribArray(GLuint) { GL_RECORD("glEnableVertexAttribArray"); }
+inline void APIENTRY vertexAttribDivisor(GLuint, GLuint) { GL_RECORD("glVertexAttribDivisor"); }
+inline void APIENTRY vertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) { GL_RECORD("glVertexAttribPointer"); }
+inline void APIENTRY drawArrays(GLenum, GLint, GLsizei) { GL_RECORD("glDrawArrays"); glRecorder().instancesDrawn++; }
+inline void APIENTRY drawElementsInstancedBaseVertex(GLenum, GLsizei, GLenum, const void*, GLsizei instances, GLint)
+{
+    GL_RECORD("glDrawElementsInstancedBaseVertex");
+    glRecorder().instancesDrawn += (unsigned long long)instances;
+}
+// reads the commands back from the bound GL_DRAW_INDIRECT_BUFFER like the driver would
+inline void APIENTRY multiDrawElementsIndirect(GLenum, GLenum, const void *indirect, GLsizei count, GLsizei)
+{
+    GL_RECORD("glMultiDrawElementsIndirect");
+    std::vector<char> *buffer = glRecorder().bound(GL_DRAW_INDIRECT_BUFFER);
+    if (!buffer)
+        return;
+    const GLuint *command = (const GLuint*)&(*buffer)[(size_t)indirect];
+    for (GLsizei i = 0; i < count; i++, command += 5)
+        glRecorder().instancesDrawn += command[1];
+}
+
+// shaders and programs
+inline GLuint APIENTRY createShader(GLenum) { GL_RECORD("glCreateShader"); return glRecorder().nextName++; }
+inline void APIENTRY shaderSource(GLuint, GLsizei, const GLchar *const*, const GLint*) { GL_RECORD("glShaderSource"); }
+inline void APIENTRY compileShader(GLuint) { GL_RECORD("glCompileShader"); }
+inline void APIENTRY getShaderiv(GLuint, GLenum pname, GLint *value)
+{
+    GL_RECORD("glGetShaderiv");
+    *value = pname == GL_INFO_LOG_LENGTH ? 0 : GL_TRUE;
+}
+inline void APIENTRY getShaderInfoLog(GLuint, GLsizei, GLsizei *length, GLchar *log)
+{
+    GL_RECORD("glGetShaderInfoLog");
+    if (length)
+        *length = 0;
+    if (log)
+        log[0] = '\0';
+}
+inline void APIENTRY deleteShader(GLuint) { GL_RECORD("glDeleteShader"); }
+inline GLuint APIENTRY createProgram()
+{
+    GL_RECORD("glCreateProgram");
+    GLuint program = glRecorder().nextName++;
+    glRecorder().linkStatus[program] = GL_FALSE;
+    return program;
+}
+inline void APIENTRY attachShader(GLuint, GLuint) { GL_RECORD("glAttachShader"); }
+inline void APIENTRY linkProgram(GLuint program) { GL_RECORD("glLinkProgram"); glRecorder().linkStatus[program] = GL_TRUE; }
+inline void APIENTRY getProgramiv(GLuint program, GLenum pname, GLint *value)
+{
+    GL_RECORD("glGetProgramiv");
+    GLRecorder &recorder = glRecorder();
+    switch (pname)
+    {
+        case GL_LINK_STATUS: *value = recorder.linkStatus[program]; break;
+        case GL_PROGRAM_BINARY_LENGTH: *value = (GLint)recorder.programBinary.size(); break;
+        case GL_ACTIVE_UNIFORMS: *value = (GLint)recorder.uniforms.size(); break;
+        case GL_ACTIVE_UNIFORM_MAX_LENGTH:
+            *value = 1;
+            for (size_t i = 0; i < recorder.uniforms.size(); i++)
+                if ((GLint)recorder.uniforms[i].name.size() + 1 > *value)
+                    *value = (GLint)recorder.uniforms[i].name.size() + 1;
+            break;
+        case GL_COMPLETION_STATUS_KHR: *value = GL_TRUE; break;
+        default: *value = 0; break;
+    }
+}
+inline void APIENTRY getProgramInfoLog(GLuint, GLsizei, GLsizei *length, GLchar *log)
+{
+    GL_RECORD("glGetProgramInfoLog");
+    if (length)
+        *length = 0;
+    if (log)
+        log[0] = '\0';
+}
+inline void APIENTRY getProgramBinary(GLuint, GLsizei size, GLsizei *length, GLenum *format, void *binary)
+{
+    GL_RECORD("glGetProgramBinary");
+    const std::vector<char> &source = glRecorder().programBinary;
+    GLsizei written = (GLsizei)source.size() < size ? (GLsizei)source.size() : size;
+    if (written > 0)
+        memcpy(binary, &source[0], (size_t)written);
+    *length = written;
+    *format = glRecorder().binaryFormat;
+}
+inline void APIENTRY programBinary(GLuint program, GLenum format, const void *binary, GLsizei length)
+{
+    GL_RECORD("glProgramBinary");
+    GLRecorder &recorder = glRecorder();
+    recorder.loadedBinary.assign((const char*)binary, (const char*)binary + length);
+    recorder.linkStatus[program] = recorder.acceptBinary && format == recorder.binaryFormat ? GL_TRUE : GL_FALSE;
+}
+inline void APIENTRY programParameteri(GLuint, GLenum, GLint) { GL_RECORD("glProgramParameteri"); }
+
+// uniforms
+inline void APIENTRY getActiveUniform(GLuint, GLuint index, GLsizei size, GLsizei *length, GLint *count, GLenum *type, GLchar *name)
+{
+    GL_RECORD("glGetActiveUniform");
+    const GLRecorder::ActiveUniform &uniform = glRecorder().uniforms[index];
+    GLsizei written = (GLsizei)uniform.name.size() < size - 1 ? (GLsizei)uniform.name.size() : size - 1;
+    memcpy(name, uniform.name.c_str(), (size_t)written);
+    name[written] = '\0';
+    if (length)
+        *length = written;
+    *count = uniform.size;
+    *type = uniform.type;
+}
+inline GLint APIENTRY getUniformLocation(GLuint, const GLchar *name)
+{
+    GL_RECORD("glGetUniformLocation");
+    const std::vector<GLRecorder::ActiveUniform> &uniforms = glRecorder().uniforms;
+    for (size_t i = 0; i < uniforms.size(); i++)
+        if (uniforms[i].name == name)
+            return (GLint)i;
+    return -1;
+}
+inline GLuint APIENTRY getUniformBlockIndex(GLuint, const GLchar*) { GL_RECORD("glGetUniformBlockIndex"); return GL_INVALID_INDEX; }
+inline void APIENTRY uniformBlockBinding(GLuint, GLuint, GLuint) { GL_RECORD("glUniformBlockBinding"); }
+inline void APIENTRY getUniformfv(GLuint, GLint, GLfloat *values) { GL_RECORD("glGetUniformfv"); memset(values, 0, 16 * sizeof(GLfloat)); }
+inline void APIENTRY getUniformiv(GLuint, GLint, GLint *values) { GL_RECORD("glGetUniformiv"); memset(values, 0, 4 * sizeof(GLint)); }
+inline void APIENTRY uniform1i(GLint, GLint) { GL_RECORD("glUniform1i"); }
+inline void APIENTRY uniform1f(GLint, GLfloat) { GL_RECORD("glUniform1f"); }
+inline void APIENTRY uniform2f(GLint, GLfloat, GLfloat) { GL_RECORD("glUniform2f"); }
+inline void APIENTRY uniform1fv(GLint, GLsizei, const GLfloat*) { GL_RECORD("glUniform1fv"); }
+inline void APIENTRY uniform2fv(GLint, GLsizei, const GLfloat*) { GL_RECORD("glUniform2fv"); }
+inline void APIENTRY uniform3fv(GLint, GLsizei, const GLfloat*) { GL_RECORD("glUniform3fv"); }
+inline void APIENTRY uniform4fv(GLint, GLsizei, const GLfloat*) { GL_RECORD("glUniform4fv"); }
+inline void APIENTRY uniform1iv(GLint, GLsizei, const GLint*) { GL_RECORD("glUniform1iv"); }
+inline void APIENTRY uniform2iv(GLint, GLsizei, const GLint*) { GL_RECORD("glUniform2iv"); }
+inline void APIENTRY uniform3iv(GLint, GLsizei, const GLint*) { GL_RECORD("glUniform3iv"); }
+inline void APIENTRY uniform4iv(GLint, GLsizei, const GLint*) { GL_RECORD("glUniform4iv"); }
+inline void APIENTRY uniformMatrix2fv(GLint, GLsizei, GLboolean, const GLfloat*) { GL_RECORD("glUniformMatrix2fv"); }
+inline void APIENTRY uniformMatrix3fv(GLint, GLsizei, GLboolean, const GLfloat*) { GL_RECORD("glUniformMatrix3fv"); }
+inline void APIENTRY uniformMatrix4fv(GLint, GLsizei, GLboolean, const GLfloat*) { GL_RECORD("glUniformMatrix4fv"); }
+
+// queries
+inline void APIENTRY getIntegerv(GLenum pname, GLint *value)
+{
+    GL_RECORD("glGetIntegerv");
+    switch (pname)
+    {
+        case GL_NUM_PROGRAM_BINARY_FORMATS: *value = glRecorder().binaryFormats; break;
+        case GL_CURRENT_PROGRAM: *value = (GLint)glRecorder().currentProgram; break;
+        case GL_MAJOR_VERSION: *value = 4; break;
+        case GL_MINOR_VERSION: *value = 1; break;
+        default: *value = 0; break;
+    }
+}
+inline const GLubyte* APIENTRY getString(GLenum name)
+{
+    GL_RECORD("glGetString");
+    const char *s = name == GL_RENDERER ? glRecorder().renderer.c_str() : name == GL_VERSION ? "4.1 GLRecorder" : "GLRecorder";
+    return (const GLubyte*)s;
+}
+
+#undef GL_RECORD
+
+} // namespace GLRecorderStubs
+
+// route glad and glExt() to the recorder; multi-draw indirect is left out unless asked for
+inline void installGLRecorder(bool multiDrawIndirect = false)
+{
+    using namespace GLRecorderStubs;
+    glad_glUseProgram = useProgram;
+    glad_glBindVertexArray = bindVertexArray;
+    glad_glActiveTexture = activeTexture;
+    glad_glBindTexture = bindTexture;
+    glad_glBindBuffer = bindBuffer;
+    glad_glBindBufferRange = bindBufferRange;
+    glad_glEnable = enable;
+    glad_glDisable = disable;
+    glad_glBlendFunc = blendFunc;
+    glad_glDepthFunc = depthFunc;
+    glad_glDepthMask = depthMask;
+    glad_glPolygonMode = polygonMode;
+    glad_glGenBuffers = genBuffers;
+    glad_glDeleteBuffers = deleteBuffers;
+    glad_glDeleteVertexArrays = deleteVertexArrays;
+    glad_glDeleteTextures = deleteTextures;
+    glad_glDeleteProgram = deleteProgram;
+    glad_glBufferData = bufferData;
+    glad_glBufferSubData = bufferSubData;
+    glad_glMapBufferRange = mapBufferRange;
+    glad_glUnmapBuffer = unmapBuffer;
+    glad_glFenceSync = fenceSync;
+    glad_glClientWaitSync = clientWaitSync;
+    glad_glDeleteSync = deleteSync;
+    glad_glEnableVertexAttribArray = enableVertexAttribArray;
+    glad_glVertexAttribDivisor = vertexAttribDivisor;
+    glad_glVertexAttribPointer = vertexAttribPointer;
+    glad_glDrawArrays = drawArrays;
+    glad_glDrawElementsInstancedBaseVertex = drawElementsInstancedBaseVertex;
+    glad_glCreateShader = createShader;
+    glad_glShaderSource = shaderSource;
+    glad_glCompileShader = compileShader;
+    glad_glGetShaderiv = getShaderiv;
+    glad_glGetShaderInfoLog = getShaderInfoLog;
+    glad_glDeleteShader = deleteShader;
+    glad_glCreateProgram = createProgram;
+    glad_glAttachShader = attachShader;
+    glad_glLinkProgram = linkProgram;
+    glad_glGetProgramiv = getProgramiv;
+    glad_glGetProgramInfoLog = getProgramInfoLog;
+    glad_glGetActiveUniform = getActiveUniform;
+    glad_glGetUniformLocation = getUniformLocation;
+    glad_glGetUniformBlockIndex = getUniformBlockIndex;
+    glad_glUniformBlockBinding = uniformBlockBinding;
+    glad_glGetUniformfv = getUniformfv;
+    glad_glGetUniformiv = getUniformiv;
+    glad_glUniform1i = uniform1i;
+    glad_glUniform1f = uniform1f;
+    glad_glUniform2f = uniform2f;
+    glad_glUniform1fv = uniform1fv;
+    glad_glUniform2fv = uniform2fv;
+    glad_glUniform3fv = uniform3fv;
+    glad_glUniform4fv = uniform4fv;
+    glad_glUniform1iv = uniform1iv;
+    glad_glUniform2iv = uniform2iv;
+    glad_glUniform3iv = uniform3iv;
+    glad_glUniform4iv = uniform4iv;
+    glad_glUniformMatrix2fv = uniformMatrix2fv;
+    glad_glUniformMatrix3fv = uniformMatrix3fv;
+    glad_glUniformMatrix4fv = uniformMatrix4fv;
+    glad_glGetIntegerv = getIntegerv;
+    glad_glGetString = getString;
+
+    GLExtensions &ext = glExt();
+    ext.major = 4;
+    ext.minor = 1;
+    ext.GetProgramBinary = getProgramBinary;
+    ext.ProgramBinary = programBinary;
+    ext.ProgramParameteri = programParameteri;
+    ext.MultiDrawElementsIndirect = multiDrawIndirect ? multiDrawElementsIndirect : NULL;
+}
+
+#endif
@@ -0,0 +1,185 @@
+//
+//  GLStateCacheTest.cpp
+//  MyOpenGLPro7
+//
+//  GLStateCache against GLRecorder: which calls reach the driver, what the
+//  issued/elided counters say, and that invalidate(), binding a vertex array
+//  and deleting objects forget exactly the state GL itself would change.
+//    c++ -std=gnu++14 -I<glad>/include tests/GLStateCacheTest.cpp <glad>/src/glad.c -o GLStateCacheTest
+//
+
+#include "TestCheck.h"
+#include "GLRecorder.h"
+#include "../headers/GLStateCache.h"
+
+#include <cstdio>
+
+static unsigned calls(const char *name) { return glRecorder().calls(name); }
+
+static void testElision()
+{
+    GLStateCache cache;
+    glRecorder().reset();
+
+    // the first call of each kind always goes out, repeats are dropped
+    cache.useProgram(3);
+    cache.useProgram(3);
+    cache.useProgram(4);
+    check(calls("glUseProgram") == 2, "repeated program elided");
+    check(cache.stats().issued[STATE_PROGRAM] == 2 && cache.stats().elided[STATE_PROGRAM] == 1, "program counters");
+    check(cache.currentProgram() == 4, "current program");
+
+    cache.bindTexture(0, GL_TEXTURE_2D, 7);
+    cache.bindTexture(1, GL_TEXTURE_2D, 8);
+    cache.bindTexture(0, GL_TEXTURE_2D, 7);
+    cache.bindTexture(1, GL_TEXTURE_2D, 8);
+    check(calls("glBindTexture") == 2, "per-unit texture bindings elided");
+    check(calls("glActiveTexture") == 2, "active unit only switched for issued binds");
+    // another target on the same unit is its own binding
+    cache.bindTexture(1, GL_TEXTURE_CUBE_MAP, 8);
+    check(calls("glBindTexture") == 3 && calls("glActiveTexture") == 2, "cube map shadowed apart from 2D on the current unit");
+
+    cache.bindBuffer(GL_ARRAY_BUFFER, 5);
+    cache.bindBuffer(GL_ARRAY_BUFFER, 5);
+    cache.bindBuffer(GL_UNIFORM_BUFFER, 5);
+    cache.bindBuffer(GL_DRAW_INDIRECT_BUFFER, 6);
+    cache.bindBuffer(GL_DRAW_INDIRECT_BUFFER, 6);
+    check(calls("glBindBuffer") == 3, "buffer bindings elided per target");
+
+    cache.bindBufferRange(GL_UNIFORM_BUFFER, 0, 9, 0, 256);
+    cache.bindBufferRange(GL_UNIFORM_BUFFER, 0, 9, 0, 256);
+    cache.bindBufferRange(GL_UNIFORM_BUFFER, 0, 9, 256, 256);
+    check(calls("glBindBufferRange") == 2, "same range elided, new offset issued");
+    // the ranged bind also moved the generic binding point
+    cache.bindBuffer(GL_UNIFORM_BUFFER, 9);
+    check(calls("glBindBuffer") == 3, "generic uniform binding follows bindBufferRange");
+
+    cache.enable(GL_DEPTH_TEST);
+    cache.enable(GL_DEPTH_TEST);
+    cache.disable(GL_BLEND);
+    cache.disable(GL_BLEND);
+    check(calls("glEnable") == 1 && calls("glDisable") == 1, "capabilities elided");
+    cache.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    cache.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    cache.depthFunc(GL_LESS);
+    cache.depthFunc(GL_LESS);
+    cache.depthMask(true);
+    cache.depthMask(true);
+    cache.depthMask(false);
+    cache.polygonMode(GL_FILL);
+    cache.polygonMode(GL_FILL);
+    check(calls("glBlendFunc") == 1 && calls("glDepthFunc") == 1 && calls("glDepthMask") == 2 && calls("glPolygonMode") == 1,
+          "fixed-function state elided");
+
+    // every call through the cache is counted exactly once, issued or elided
+    const GLStateCache::Stats &stats = cache.stats();
+    check(stats.totalIssued() == glRecorder().totalCalls(), "issued counter matches the driver calls");
+    check(stats.totalIssued() + stats.totalElided() == 33, "every call counted once");
+
+    cache.resetStats();
+    check(cache.stats().totalIssued() == 0 && cache.stats().totalElided() == 0, "resetStats clears counters");
+    cache.useProgram(4);
+    check(cache.stats().elided[STATE_PROGRAM] == 1, "resetStats keeps the shadowed state");
+}
+
+static void testInvalidate()
+{
+    GLStateCache cache;
+    cache.useProgram(3);
+    cache.bindVertexArray(2);
+    cache.bindTexture(0, GL_TEXTURE_2D, 7);
+    cache.bindBuffer(GL_ARRAY_BUFFER, 5);
+    cache.enable(GL_DEPTH_TEST);
+    cache.depthMask(true);
+    glRecorder().reset();
+
+    // after someone else touched GL, the same values must go out again
+    cache.invalidate();
+    cache.useProgram(3);
+    cache.bindVertexArray(2);
+    cache.bindTexture(0, GL_TEXTURE_2D, 7);
+    cache.bindBuffer(GL_ARRAY_BUFFER, 5);
+    cache.enable(GL_DEPTH_TEST);
+    cache.depthMask(true);
+    check(calls("glUseProgram") == 1 && calls("glBindVertexArray") == 1 && calls("glBindTexture") == 1
+          && calls("glActiveTexture") == 1 && calls("glBindBuffer") == 1 && calls("glEnable") == 1 && calls("glDepthMask") == 1,
+          "invalidate makes every call go out again");
+    check(cache.currentProgram() == 3, "current program after invalidate and rebind");
+    cache.invalidate();
+    check(cache.currentProgram() == 0, "unknown program reads as 0");
+}
+
+static void testVertexArrayResetsElements()
+{
+    GLStateCache cache;
+    cache.bindVertexArray(1);
+    cache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 10);
+    cache.bindBuffer(GL_ARRAY_BUFFER, 11);
+    glRecorder().reset();
+
+    // the element binding belongs to the VAO: switching VAOs forgets it, the array binding is global
+    cache.bindVertexArray(2);
+    cache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 10);
+    cache.bindBuffer(GL_ARRAY_BUFFER, 11);
+    check(calls("glBindBuffer") == 1, "element buffer rebound after a VAO switch, array buffer not");
+
+    // binding the same VAO again is elided and keeps the element shadow
+    cache.bindVertexArray(2);
+    cache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 10);
+    check(calls("glBindVertexArray") == 1 && calls("glBindBuffer") == 1, "same VAO keeps its element binding");
+
+    // deleting the bound VAO falls back to 0 and forgets the element binding too
+    cache.deleteVertexArray(2);
+    cache.bindVertexArray(0);
+    cache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 10);
+    check(calls("glDeleteVertexArrays") == 1 && calls("glBindVertexArray") == 1 && calls("glBindBuffer") == 2,
+          "deleted VAO reads as 0 and its element binding is forgotten");
+}
+
+static void testDeleteUnbinds()
+{
+    GLStateCache cache;
+    cache.bindBuffer(GL_ARRAY_BUFFER, 5);
+    cache.bindBuffer(GL_COPY_READ_BUFFER, 5);
+    cache.bindBuffer(GL_COPY_WRITE_BUFFER, 6);
+    cache.bindBufferRange(GL_UNIFORM_BUFFER, 1, 5, 0, 64);
+    cache.bindTexture(0, GL_TEXTURE_2D, 7);
+    cache.bindTexture(3, GL_TEXTURE_2D, 7);
+    cache.bindTexture(1, GL_TEXTURE_2D, 8);
+    glRecorder().reset();
+
+    // GL unbinds a deleted buffer everywhere; a new buffer reusing the name must be bound again
+    cache.deleteBuffer(5);
+    check(calls("glDeleteBuffers") == 1, "buffer deleted");
+    cache.bindBuffer(GL_ARRAY_BUFFER, 0);
+    cache.bindBuffer(GL_COPY_READ_BUFFER, 0);
+    check(calls("glBindBuffer") == 0, "deleted buffer's targets read as 0");
+    cache.bindBuffer(GL_ARRAY_BUFFER, 5);
+    cache.bindBuffer(GL_COPY_READ_BUFFER, 5);
+    cache.bindBufferRange(GL_UNIFORM_BUFFER, 1, 5, 0, 64);
+    check(calls("glBindBuffer") == 2 && calls("glBindBufferRange") == 1, "reused buffer name bound again");
+    cache.bindBuffer(GL_COPY_WRITE_BUFFER, 6);
+    check(calls("glBindBuffer") == 2, "other buffers keep their binding");
+
+    cache.deleteTexture(7);
+    cache.bindTexture(0, GL_TEXTURE_2D, 7);
+    cache.bindTexture(3, GL_TEXTURE_2D, 7);
+    cache.bindTexture(1, GL_TEXTURE_2D, 8);
+    check(calls("glDeleteTextures") == 1 && calls("glBindTexture") == 2, "deleted texture rebound on every unit it was on");
+
+    // a program in use stays current until replaced, so deleting it changes nothing for the cache
+    cache.useProgram(3);
+    cache.deleteProgram(3);
+    cache.useProgram(3);
+    check(calls("glDeleteProgram") == 1 && calls("glUseProgram") == 1, "deleted program stays current");
+}
+
+int main()
+{
+    installGLRecorder();
+    testElision();
+    testInvalidate();
+    testVertexArrayResetsElements();
+    testDeleteUnbinds();
+    return checkResult("state cache");
+}
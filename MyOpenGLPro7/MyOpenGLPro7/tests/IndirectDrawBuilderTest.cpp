@@ -0,0 +1,124 @@
+//
+//  IndirectDrawBuilderTest.cpp
+//  MyOpenGLPro7
+//
+//  IndirectDrawBuilder without GL: the MeshRange each addMesh hands out,
+//  the packed vertex and index arrays behind them, and the command records
+//  add() builds, including when it extends the previous draw instead.
+//    c++ -std=gnu++14 -I<glad>/include tests/IndirectDrawBuilderTest.cpp -o IndirectDrawBuilderTest
+//
+
+#include "TestCheck.h"
+#include "../headers/IndirectDrawBuilder.h"
+
+#include <cstdio>
+#include <cstring>
+
+struct Vertex
+{
+    float position[3];
+    float texCoord[2];
+};
+
+static bool sameCommand(const DrawElementsIndirectCommand &command, GLuint count, GLuint instanceCount,
+                        GLuint firstIndex, GLint baseVertex, GLuint baseInstance)
+{
+    return command.count == count && command.instanceCount == instanceCount && command.firstIndex == firstIndex
+        && command.baseVertex == baseVertex && command.baseInstance == baseInstance;
+}
+
+static void testPacking()
+{
+    // a quad and two triangles, each indexed from 0
+    Vertex quad[4] = {};
+    Vertex triangle[3] = {};
+    Vertex other[3] = {};
+    for (int v = 0; v < 4; v++)
+        quad[v].position[0] = (float)v;
+    for (int v = 0; v < 3; v++)
+    {
+        triangle[v].position[0] = 10.0f + v;
+        other[v].position[0] = 20.0f + v;
+    }
+    const GLushort quadIndices[] = { 0, 1, 2, 2, 3, 0 };
+    const GLushort triangleIndices[] = { 0, 1, 2 };
+    const GLushort otherIndices[] = { 2, 1, 0 };
+
+    IndirectDrawBuilder builder(sizeof(Vertex));
+    check(builder.stride() == sizeof(Vertex), "stride kept");
+    MeshRange first = builder.addMesh(quad, 4, quadIndices, 6);
+    MeshRange second = builder.addMesh(triangle, 3, triangleIndices, 3);
+    MeshRange third = builder.addMesh(other, 3, otherIndices, 3);
+
+    check(first.firstIndex == 0 && first.indexCount == 6 && first.baseVertex == 0, "first mesh starts the pool");
+    check(second.firstIndex == 6 && second.indexCount == 3 && second.baseVertex == 4, "second mesh follows the first");
+    check(third.firstIndex == 9 && third.indexCount == 3 && third.baseVertex == 7, "third mesh follows the second");
+
+    check(builder.vertexData().size() == 10 * sizeof(Vertex), "vertex pool holds every vertex");
+    check(builder.indexData().size() == 12, "index pool holds every index");
+    // indices stay relative to their mesh, baseVertex does the moving
+    check(memcmp(&builder.indexData()[6], triangleIndices, sizeof(triangleIndices)) == 0, "indices copied unshifted");
+    const Vertex *pool = (const Vertex*)&builder.vertexData()[0];
+    check(pool[second.baseVertex + triangleIndices[1]].position[0] == 11.0f, "baseVertex finds the second mesh's vertices");
+    check(pool[third.baseVertex + otherIndices[0]].position[0] == 22.0f, "baseVertex finds the third mesh's vertices");
+}
+
+static void testCommands()
+{
+    IndirectDrawBuilder builder(sizeof(Vertex));
+    Vertex vertices[4] = {};
+    const GLushort indices[] = { 0, 1, 2, 2, 3, 0 };
+    MeshRange quad = builder.addMesh(vertices, 4, indices, 6);
+    MeshRange triangle = builder.addMesh(vertices, 3, indices, 3);
+
+    builder.add(quad, 5, 0);
+    builder.add(triangle, 2, 5);
+    check(builder.commandCount() == 2, "one command per mesh");
+    check(sameCommand(builder.commands()[0], 6, 5, 0, 0, 0), "quad command");
+    check(sameCommand(builder.commands()[1], 3, 2, 6, 4, 5), "triangle command");
+
+    // the triangle again with the next instances extends the last draw
+    builder.add(triangle, 3, 7);
+    check(builder.commandCount() == 2, "contiguous instances merged");
+    check(sameCommand(builder.commands()[1], 3, 5, 6, 4, 5), "merged command covers both runs");
+
+    // a gap in the instances, another mesh in between, or a different mesh does not merge
+    builder.add(triangle, 1, 20);
+    check(builder.commandCount() == 3 && sameCommand(builder.commands()[2], 3, 1, 6, 4, 20), "instance gap starts a new command");
+    builder.add(quad, 1, 21);
+    check(builder.commandCount() == 4 && sameCommand(builder.commands()[3], 6, 1, 0, 0, 21), "other mesh starts a new command");
+    builder.add(triangle, 1, 22);
+    check(builder.commandCount() == 5, "same mesh after another one is not merged back");
+
+    // clear starts a new list, the meshes stay packed
+    builder.clear();
+    check(builder.commandCount() == 0, "clear empties the list");
+    check(builder.indexData().size() == 9, "clear keeps the packed meshes");
+    builder.add(triangle, 4, 0);
+    check(builder.commandCount() == 1 && sameCommand(builder.commands()[0], 3, 4, 6, 4, 0), "first command after clear");
+}
+
+static void testNoStride()
+{
+    // without a stride the builder only builds command lists
+    IndirectDrawBuilder builder;
+    Vertex vertices[3] = {};
+    const GLushort indices[] = { 0, 1, 2 };
+    MeshRange range = builder.addMesh(vertices, 3, indices, 3);
+    check(range.indexCount == 0 && builder.vertexData().empty() && builder.indexData().empty(), "no stride packs nothing");
+
+    MeshRange external;
+    external.firstIndex = 30;
+    external.indexCount = 36;
+    external.baseVertex = 100;
+    builder.add(external, 2, 8);
+    check(sameCommand(builder.commands()[0], 36, 2, 30, 100, 8), "ranges from elsewhere still make commands");
+}
+
+int main()
+{
+    testPacking();
+    testCommands();
+    testNoStride();
+    return checkResult("indirect draw builder");
+}
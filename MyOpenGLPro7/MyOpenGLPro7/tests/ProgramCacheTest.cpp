@@ -0,0 +1,206 @@
+//
+//  ProgramCacheTest.cpp
+//  MyOpenGLPro7
+//
+//  ProgramCache against GLRecorder's glProgramBinary / glGetProgramBinary:
+//  entries round-trip, and a wrong key, a truncated file or a binary the
+//  driver rejects all miss and delete the entry. Writes to ./programcache-test.
+//    c++ -std=gnu++14 -I<glad>/include tests/ProgramCacheTest.cpp <glad>/src/glad.c -o ProgramCacheTest
+//
+
+#include "TestCheck.h"
+#include "GLRecorder.h"
+#include "../headers/ProgramCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static const char *DIRECTORY = "programcache-test";
+static const char VERTEX[] = "#version 330 core\nvoid main() { gl_Position = vec4(0.0); }\n";
+static const char FRAGMENT[] = "#version 330 core\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n";
+// magic, version, key, format, length
+static const size_t HEADER_SIZE = 24;
+
+static std::string entryPath(uint64_t key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return std::string(DIRECTORY) + "/" + name;
+}
+
+static std::vector<char> readFile(const std::string &path)
+{
+    std::vector<char> bytes;
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+        return bytes;
+    char buffer[256];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        bytes.insert(bytes.end(), buffer, buffer + read);
+    fclose(file);
+    return bytes;
+}
+
+static void writeFile(const std::string &path, const std::vector<char> &bytes)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file)
+        return;
+    fwrite(&bytes[0], 1, bytes.size(), file);
+    fclose(file);
+}
+
+static bool exists(const std::string &path)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file)
+        fclose(file);
+    return file != NULL;
+}
+
+static uint64_t sourceKey(const ProgramCache &cache, const char *fragment)
+{
+    return cache.key(VERTEX, sizeof(VERTEX) - 1, fragment, strlen(fragment));
+}
+
+// a linked program the cache is allowed to store
+static GLuint linkedProgram(const ProgramCache &cache)
+{
+    GLuint program = glCreateProgram();
+    cache.prepare(program);
+    glLinkProgram(program);
+    return program;
+}
+
+static void resetDriver()
+{
+    GLRecorder &recorder = glRecorder();
+    const char binary[] = "not really a program binary";
+    recorder.programBinary.assign(binary, binary + sizeof(binary));
+    recorder.binaryFormat = 0x8E7A;
+    recorder.acceptBinary = true;
+    recorder.binaryFormats = 1;
+    recorder.renderer = "GLRecorder";
+    recorder.loadedBinary.clear();
+    recorder.reset();
+}
+
+static void testRoundTrip()
+{
+    resetDriver();
+    ProgramCache cache(DIRECTORY);
+    check(cache.supported(), "binary formats make the cache usable");
+    uint64_t key = sourceKey(cache, FRAGMENT);
+    remove(entryPath(key).c_str());
+    check(cache.load(key) == 0, "empty cache misses");
+
+    cache.store(key, linkedProgram(cache));
+    check(glRecorder().calls("glProgramParameteri") == 1, "prepare asks for a retrievable binary");
+    std::vector<char> file = readFile(entryPath(key));
+    check(file.size() == HEADER_SIZE + glRecorder().programBinary.size(), "entry is header plus binary");
+    check(!exists(entryPath(key) + ".tmp"), "no temporary left behind");
+
+    glRecorder().reset();
+    GLuint program = cache.load(key);
+    check(program != 0, "stored entry loads");
+    check(glRecorder().calls("glProgramBinary") == 1, "loading hands the binary to the driver");
+    check(glRecorder().loadedBinary == glRecorder().programBinary, "binary round-trips unchanged");
+    check(glRecorder().calls("glDeleteProgram") == 0, "accepted program is kept");
+    check(exists(entryPath(key)), "good entry stays on disk");
+    remove(entryPath(key).c_str());
+}
+
+static void testKeyMismatch()
+{
+    resetDriver();
+    ProgramCache cache(DIRECTORY);
+    uint64_t key = sourceKey(cache, FRAGMENT);
+    uint64_t other = sourceKey(cache, "#version 330 core\nout vec4 color;\nvoid main() { color = vec4(0.5); }\n");
+    check(key != other, "different sources, different keys");
+    cache.store(key, linkedProgram(cache));
+
+    // an entry whose header names another key, as after a hash collision or a copied file
+    writeFile(entryPath(other), readFile(entryPath(key)));
+    glRecorder().reset();
+    check(cache.load(other) == 0, "header key mismatch misses");
+    check(glRecorder().calls("glProgramBinary") == 0, "mismatched entry never reaches the driver");
+    check(!exists(entryPath(other)), "mismatched entry is deleted");
+    check(exists(entryPath(key)), "the real entry is untouched");
+
+    // another driver hashes to another key, so its binaries are never offered to this one
+    glRecorder().renderer = "Another Renderer";
+    ProgramCache updated(DIRECTORY);
+    check(sourceKey(updated, FRAGMENT) != key, "driver strings are part of the key");
+    check(updated.load(sourceKey(updated, FRAGMENT)) == 0, "new driver misses");
+    remove(entryPath(key).c_str());
+}
+
+static void testTruncated()
+{
+    resetDriver();
+    ProgramCache cache(DIRECTORY);
+    uint64_t key = sourceKey(cache, FRAGMENT);
+    cache.store(key, linkedProgram(cache));
+    std::vector<char> whole = readFile(entryPath(key));
+
+    // cut inside the binary, then inside the header
+    const size_t lengths[] = { whole.size() - 1, HEADER_SIZE, HEADER_SIZE / 2 };
+    for (size_t length : lengths)
+    {
+        writeFile(entryPath(key), std::vector<char>(whole.begin(), whole.begin() + length));
+        glRecorder().reset();
+        check(cache.load(key) == 0, "truncated entry misses");
+        check(glRecorder().calls("glProgramBinary") == 0, "truncated entry never reaches the driver");
+        check(!exists(entryPath(key)), "truncated entry is deleted");
+    }
+}
+
+static void testRejected()
+{
+    resetDriver();
+    ProgramCache cache(DIRECTORY);
+    uint64_t key = sourceKey(cache, FRAGMENT);
+    cache.store(key, linkedProgram(cache));
+
+    // a driver update that kept its version string but no longer takes the old binary
+    glRecorder().acceptBinary = false;
+    glRecorder().reset();
+    check(cache.load(key) == 0, "rejected binary misses");
+    check(glRecorder().calls("glProgramBinary") == 1, "rejected binary was offered once");
+    check(glRecorder().calls("glDeleteProgram") == 1, "rejected program is deleted");
+    check(!exists(entryPath(key)), "rejected entry is deleted");
+
+    // and the next store writes a fresh one
+    glRecorder().acceptBinary = true;
+    cache.store(key, linkedProgram(cache));
+    check(cache.load(key) != 0, "fresh entry loads after a rejection");
+    remove(entryPath(key).c_str());
+}
+
+static void testUnsupported()
+{
+    resetDriver();
+    glRecorder().binaryFormats = 0;
+    ProgramCache cache(DIRECTORY);
+    uint64_t key = sourceKey(cache, FRAGMENT);
+    check(!cache.supported(), "no binary formats disables the cache");
+    cache.store(key, linkedProgram(cache));
+    check(glRecorder().calls("glGetProgramBinary") == 0, "disabled cache reads no binary");
+    check(!exists(entryPath(key)), "disabled cache writes nothing");
+    check(cache.load(key) == 0, "disabled cache misses");
+}
+
+int main()
+{
+    installGLRecorder();
+    testRoundTrip();
+    testKeyMismatch();
+    testTruncated();
+    testRejected();
+    testUnsupported();
+    remove(DIRECTORY);
+    return checkResult("program cache");
+}
@@ -0,0 +1,163 @@
+//
+//  ReverseDepthTest.cpp
+//  MyOpenGLPro7
+//
+//  Checks Camera's DEPTH_REVERSED projection, Frustum::fromMatrix with
+//  reversedDepth and Camera::Unproject against values worked out by hand.
+//  Needs no GL context, only glm and the glad header:
+//    c++ -std=gnu++14 -I<glad>/include tests/ReverseDepthTest.cpp -o ReverseDepthTest
+//
+
+#include "TestCheck.h"
+#include "../headers/camera.h"
+#include "../headers/Frustum.h"
+
+#include <cmath>
+#include <cstdio>
+
+static bool near(float a, float b, float tolerance)
+{
+    return std::fabs(a - b) <= tolerance * std::fmax(1.0f, std::fabs(b));
+}
+
+static bool nearPlane(const glm::vec4 &a, const glm::vec4 &b)
+{
+    return near(a.x, b.x, 1e-5f) && near(a.y, b.y, 1e-5f) && near(a.z, b.z, 1e-5f) && near(a.w, b.w, 1e-5f);
+}
+
+// window depth of the point distance units straight ahead of a camera at the origin
+static float depthAt(const glm::mat4 &projection, float distance, Camera::DepthMode mode)
+{
+    glm::vec4 clip = projection * glm::vec4(0.0f, 0.0f, -distance, 1.0f);
+    float z = clip.z / clip.w;
+    return mode == Camera::DEPTH_REVERSED ? z : z * 0.5f + 0.5f;
+}
+
+// how much further than distance a point must be before its float depth changes
+static float depthResolution(const glm::mat4 &projection, float distance, Camera::DepthMode mode)
+{
+    float depth = depthAt(projection, distance, mode);
+    float low = distance, high = distance * 2.0f;
+    for (int i = 0; i < 100; i++)
+    {
+        float middle = 0.5f * (low + high);
+        if (depthAt(projection, middle, mode) == depth)
+            low = middle;
+        else
+            high = middle;
+    }
+    return high - distance;
+}
+
+static void testProjection()
+{
+    // 60 degrees, 2:1, near 0.5: x scale 1 / (tan(30) * 2), y scale 1 / tan(30)
+    glm::mat4 projection = Camera::BuildProjection(60.0f, 2.0f, 0.5f, 100.0f, Camera::DEPTH_REVERSED);
+    glm::mat4 expected(0.0f);
+    expected[0][0] = 0.8660254f;
+    expected[1][1] = 1.7320508f;
+    expected[2][3] = -1.0f;
+    expected[3][2] = 0.5f;
+    bool same = true;
+    for (int c = 0; c < 4; c++)
+        for (int r = 0; r < 4; r++)
+            same = same && near(projection[c][r], expected[c][r], 1e-6f);
+    check(same, "reversed projection matrix");
+
+    glm::mat4 otherFar = Camera::BuildProjection(60.0f, 2.0f, 0.5f, 1e6f, Camera::DEPTH_REVERSED);
+    check(otherFar == projection, "reversed projection ignores the far plane");
+
+    // depth is near / distance: 1 at the near plane, towards 0 at infinity and never below it
+    check(near(depthAt(projection, 0.5f, Camera::DEPTH_REVERSED), 1.0f, 1e-6f), "reversed depth 1 at near");
+    check(near(depthAt(projection, 5.0f, Camera::DEPTH_REVERSED), 0.1f, 1e-6f), "reversed depth 0.1 at 10 x near");
+    check(near(depthAt(projection, 5e5f, Camera::DEPTH_REVERSED), 1e-6f, 1e-6f), "reversed depth at 1e6 x near");
+    float far = depthAt(projection, 1e30f, Camera::DEPTH_REVERSED);
+    check(far > 0.0f && far < 1e-29f, "reversed depth stays above 0 at 1e30");
+    bool decreasing = true;
+    for (float d = 0.5f; d < 1e6f; d *= 1.5f)
+        decreasing = decreasing && depthAt(projection, d * 1.5f, Camera::DEPTH_REVERSED) < depthAt(projection, d, Camera::DEPTH_REVERSED);
+    check(decreasing, "reversed depth falls with distance");
+}
+
+static void testPrecision()
+{
+    // near 0.1, far 1e5: the standard curve loses distant surfaces, the reversed one keeps float's relative precision
+    glm::mat4 standard = Camera::BuildProjection(45.0f, 16.0f / 9.0f, 0.1f, 1e5f, Camera::DEPTH_STANDARD);
+    glm::mat4 reversed = Camera::BuildProjection(45.0f, 16.0f / 9.0f, 0.1f, 1e5f, Camera::DEPTH_REVERSED);
+    const float distances[] = { 1.0f, 10.0f, 100.0f, 1000.0f, 10000.0f, 50000.0f };
+    for (float d : distances)
+    {
+        float standardStep = depthResolution(standard, d, Camera::DEPTH_STANDARD);
+        float reversedStep = depthResolution(reversed, d, Camera::DEPTH_REVERSED);
+        check(reversedStep / d < 1e-6f, "reversed depth resolves 1e-6 of the distance");
+        if (d >= 100.0f)
+            check(reversedStep * 100.0f < standardStep, "reversed depth 100x finer than standard far away");
+    }
+}
+
+static void testFrustum()
+{
+    // looking down +x from (1, 2, 3)
+    Camera camera(glm::vec3(1.0f, 2.0f, 3.0f), glm::vec3(0.0f, 1.0f, 0.0f), 0.0f, 0.0f);
+    camera.SetProjection(1.0f, 0.5f, 100.0f);
+    Frustum standard = Frustum::fromMatrix(camera.GetViewProjectionMatrix());
+    camera.SetDepthMode(Camera::DEPTH_REVERSED);
+    Frustum reversed = Frustum::fromMatrix(camera.GetViewProjectionMatrix(), true);
+
+    // near plane faces along the view through position + 0.5 x front; the infinite far plane holds everything
+    check(nearPlane(reversed.planes[Frustum::NEAR_PLANE], glm::vec4(1.0f, 0.0f, 0.0f, -1.5f)), "reversed near plane");
+    check(nearPlane(reversed.planes[Frustum::FAR_PLANE], glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)), "reversed far plane is infinite");
+    check(nearPlane(standard.planes[Frustum::NEAR_PLANE], glm::vec4(1.0f, 0.0f, 0.0f, -1.5f)), "standard near plane");
+    check(nearPlane(standard.planes[Frustum::FAR_PLANE], glm::vec4(-1.0f, 0.0f, 0.0f, 101.0f)), "standard far plane");
+    // the side planes do not depend on the depth mode; at 45 degrees each leans 22.5 degrees off the view
+    for (int p = Frustum::LEFT; p <= Frustum::TOP; p++)
+        check(nearPlane(reversed.planes[p], standard.planes[p]), "side planes match the standard frustum");
+    float lean = std::sin(glm::radians(22.5f));
+    check(near(reversed.planes[Frustum::LEFT].x, lean, 1e-5f), "left plane angle");
+
+    check(reversed.intersectsSphere(glm::vec3(1e7f, 2.0f, 3.0f), 0.1f), "far ahead is inside the reversed frustum");
+    check(!standard.intersectsSphere(glm::vec3(1e7f, 2.0f, 3.0f), 0.1f), "far ahead is outside the standard frustum");
+    check(!reversed.intersectsSphere(glm::vec3(-5.0f, 2.0f, 3.0f), 0.1f), "behind is outside");
+    check(!reversed.intersectsSphere(glm::vec3(1.2f, 2.0f, 3.0f), 0.1f), "closer than near is outside");
+    check(!reversed.intersectsSphere(glm::vec3(10.0f, 20.0f, 3.0f), 0.1f), "off to the side is outside");
+}
+
+static void testUnproject()
+{
+    Camera camera(glm::vec3(0.0f, 0.0f, 0.0f));
+    camera.SetProjection(2.0f, 0.5f, 100.0f);
+    camera.SetDepthMode(Camera::DEPTH_REVERSED);
+
+    // depth z lies near / z in front of the camera, 1 at the near plane down to 0 at infinity
+    const float depths[] = { 1.0f, 0.5f, 0.25f, 0.1f, 0.01f, 1e-3f, 1e-5f };
+    for (float z : depths)
+    {
+        glm::vec3 centre = camera.Unproject(glm::vec3(0.0f, 0.0f, z));
+        check(near(centre.z, -0.5f / z, 1e-4f) && near(centre.x, 0.0f, 1e-4f) && near(centre.y, 0.0f, 1e-4f), "unproject centre");
+        // the right top corner widens with the field of view: tan(22.5) up, twice that across
+        glm::vec3 corner = camera.Unproject(glm::vec3(1.0f, 1.0f, z));
+        float half = std::tan(glm::radians(22.5f)) * 0.5f / z;
+        check(near(corner.x, 2.0f * half, 1e-4f) && near(corner.y, half, 1e-4f) && near(corner.z, -0.5f / z, 1e-4f), "unproject corner");
+    }
+    glm::vec3 infinity = camera.Unproject(glm::vec3(0.0f, 0.0f, 0.0f));
+    check(!std::isfinite(infinity.z), "depth 0 is at infinity");
+
+    // and it inverts the projection everywhere in between
+    bool roundTrip = true;
+    for (float z = 1.0f; z > 1e-4f; z *= 0.8f)
+    {
+        glm::vec4 clip = camera.GetViewProjectionMatrix() * glm::vec4(camera.Unproject(glm::vec3(0.3f, -0.7f, z)), 1.0f);
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        roundTrip = roundTrip && near(ndc.x, 0.3f, 1e-4f) && near(ndc.y, -0.7f, 1e-4f) && near(ndc.z, z, 1e-4f);
+    }
+    check(roundTrip, "unproject inverts the reversed projection");
+}
+
+int main()
+{
+    testProjection();
+    testPrecision();
+    testFrustum();
+    testUnproject();
+    return checkResult("reverse depth");
+}
@@ -0,0 +1,42 @@
+//
+//  TestCheck.h
+//  MyOpenGLPro7
+//
+//  The few lines every program in tests/ needs: check() reports a failed
+//  expectation and counts it, checkResult() prints the verdict and gives
+//  main() its exit code.
+//
+
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <cstdio>
+
+inline int& checkFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+inline void check(bool ok, const char *what)
+{
+    if (!ok)
+    {
+        printf("FAILED: %s\n", what);
+        checkFailures()++;
+    }
+}
+
+// 0 when every check passed, 1 otherwise
+inline int checkResult(const char *suite)
+{
+    if (checkFailures())
+    {
+        printf("%s: %d checks failed\n", suite, checkFailures());
+        return 1;
+    }
+    printf("%s: all checks passed\n", suite);
+    return 0;
+}
+
+#endif
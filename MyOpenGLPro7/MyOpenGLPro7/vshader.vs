@@ -5,12 +5,17 @@ layout (location = 1) in vec2 aLoc;
 
 out vec2 loc;
 
+#include "perframe.glsl"
+
+#ifdef INSTANCED
+// one model matrix per instance, streamed by RenderQueue
+layout (location = 2) in mat4 model;
+#else
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 project;
+#endif
 
 void main()
 {
-    gl_Position = project * view * model * vec4(aPos, 1.0);
+    gl_Position = viewProject * model * vec4(aPos, 1.0);
     loc = vec2(aLoc.x, aLoc.y);
 }